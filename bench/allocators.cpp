@@ -0,0 +1,86 @@
+/// @file
+/// @author github.com/SirJonthe
+/// @date 2023
+/// @copyright Public domain.
+/// @license CC0 1.0
+/// @brief Compares dictionaries allocating from the global heap with dictionaries allocating from a bump arena. Build with optimizations together with dict.cpp, e.g. c++ -std=c++11 -O2 bench/allocators.cpp dict.cpp -o bench_allocators
+
+#include <chrono>
+#include <cstdio>
+#include "../dict.h"
+
+typedef std::chrono::steady_clock clock_type;
+
+static cc0::bump_arena &request_arena( void )
+{
+	static thread_local cc0::bump_arena a;
+	return a;
+}
+
+struct arena_policy : cc0::dict_policy
+{
+	typedef cc0::arena_allocator<request_arena> allocator;
+};
+
+struct arena_segmented_policy : cc0::dict_policy
+{
+	typedef cc0::arena_allocator<request_arena> allocator;
+	typedef cc0::segmented_growth               growth;
+};
+
+/// @brief Returns the number of milliseconds since a point in time.
+static double ms_since(clock_type::time_point t)
+{
+	return std::chrono::duration<double, std::milli>(clock_type::now() - t).count();
+}
+
+/// @brief Simulates requests that each fill many small, short-lived dictionaries.
+template < typename policy_t >
+static double requests(int num_requests, int num_dicts, int num_keys, bool clear_arena)
+{
+	uint64_t sum = 0;
+	const clock_type::time_point t = clock_type::now();
+	for (int r = 0; r < num_requests; ++r) {
+		cc0::dict<uint64_t, uint64_t, policy_t> *d = new cc0::dict<uint64_t, uint64_t, policy_t>[num_dicts];
+		for (int i = 0; i < num_dicts; ++i) {
+			for (int k = 0; k < num_keys; ++k) {
+				d[i](uint64_t(k) * 0x9E3779B97F4A7C15ULL + uint64_t(r)) = uint64_t(k);
+			}
+			sum += d[i].size();
+		}
+		delete [] d;
+		if (clear_arena) {
+			request_arena().clear();
+		}
+	}
+	const double ms = ms_since(t);
+	if (sum == 1) {
+		std::printf(" ");
+	}
+	return ms;
+}
+
+/// @brief Fills a single large dictionary.
+template < typename policy_t >
+static double load(uint64_t n)
+{
+	const clock_type::time_point t = clock_type::now();
+	{
+		cc0::dict<uint64_t, uint64_t, policy_t> d;
+		for (uint64_t i = 0; i < n; ++i) {
+			d(i * 0x9E3779B97F4A7C15ULL) = i;
+		}
+	}
+	const double ms = ms_since(t);
+	request_arena().clear();
+	return ms;
+}
+
+int main()
+{
+	for (int i = 0; i < 3; ++i) {
+		std::printf("2000 requests x 200 dicts x 8 keys: heap %.1f ms, arena %.1f ms\n", requests<cc0::dict_policy>(2000, 200, 8, false), requests<arena_policy>(2000, 200, 8, true));
+		std::printf("1M-key load: heap %.1f ms, arena %.1f ms, arena + segmented %.1f ms\n", load<cc0::dict_policy>(1000000), load<arena_policy>(1000000), load<arena_segmented_policy>(1000000));
+	}
+	return 0;
+}
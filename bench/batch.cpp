@@ -0,0 +1,99 @@
+/// @file
+/// @author github.com/SirJonthe
+/// @date 2023
+/// @copyright Public domain.
+/// @license CC0 1.0
+/// @brief Compares lookup_batch with the [] operator on a dictionary too large for the caches. Build with optimizations together with dict.cpp, e.g. c++ -std=c++11 -O2 bench/batch.cpp dict.cpp -o bench_batch, and run with the number of keys as argument.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "../dict.h"
+
+typedef std::chrono::steady_clock clock_type;
+
+struct critbit_policy : cc0::dict_policy
+{
+	typedef cc0::critbit_engine engine;
+};
+
+struct flat_policy : cc0::dict_policy
+{
+	typedef cc0::flat_engine engine;
+};
+
+/// @brief Returns the average number of nanoseconds per operation between two points in time.
+static double ns_per_op(clock_type::time_point a, clock_type::time_point b, uint64_t ops)
+{
+	return std::chrono::duration<double, std::nano>(b - a).count() / double(ops);
+}
+
+/// @brief Scrambles a number, so that keys are spread over the whole key space and looked up in an order unrelated to the order they were inserted in.
+static uint64_t scramble(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+template < typename policy_t >
+static void run(const char *name, uint64_t n)
+{
+	const uint64_t q = 9999872; // A multiple of the batch size.
+	cc0::dict<uint64_t, uint64_t, policy_t> d;
+	std::vector<uint64_t> hits;
+	std::vector<uint64_t> misses;
+	std::vector<uint64_t*> out(256);
+	uint64_t sum = 0;
+
+	// NOTE: Keys i < n are present, keys i >= n are absent.
+	for (uint64_t i = 0; i < n; ++i) {
+		d(scramble(i)) = i;
+	}
+	for (uint64_t i = 0; i < q; ++i) {
+		hits.push_back(scramble(scramble(i + 1) % n));
+		misses.push_back(scramble(n + i));
+	}
+
+	const clock_type::time_point t0 = clock_type::now();
+	for (uint64_t i = 0; i < q; ++i) {
+		sum += *d[hits[i]];
+	}
+	const clock_type::time_point t1 = clock_type::now();
+	for (uint64_t i = 0; i < q; i += out.size()) {
+		d.lookup_batch(&hits[i], out.size(), out.data());
+		for (uint64_t j = 0; j < out.size(); ++j) {
+			sum += *out[j];
+		}
+	}
+	const clock_type::time_point t2 = clock_type::now();
+	for (uint64_t i = 0; i < q; ++i) {
+		sum += d[misses[i]] != nullptr ? 1 : 0;
+	}
+	const clock_type::time_point t3 = clock_type::now();
+	for (uint64_t i = 0; i < q; i += out.size()) {
+		d.lookup_batch(&misses[i], out.size(), out.data());
+		for (uint64_t j = 0; j < out.size(); ++j) {
+			sum += out[j] != nullptr ? 1 : 0;
+		}
+	}
+	const clock_type::time_point t4 = clock_type::now();
+
+	std::printf(
+		"%-8s n=%-9llu hit: [] %5.0f  lookup_batch %5.0f ns  miss: [] %5.0f  lookup_batch %5.0f ns (%llu)\n",
+		name, (unsigned long long)n,
+		ns_per_op(t0, t1, q), ns_per_op(t1, t2, q), ns_per_op(t2, t3, q), ns_per_op(t3, t4, q),
+		(unsigned long long)(sum % 7)
+	);
+}
+
+int main(int argc, char **argv)
+{
+	const uint64_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+	run<cc0::dict_policy>("trie", n);
+	run<critbit_policy>("critbit", n);
+	run<flat_policy>("flat", n);
+	return 0;
+}
@@ -0,0 +1,107 @@
+/// @file
+/// @author github.com/SirJonthe
+/// @date 2023
+/// @copyright Public domain.
+/// @license CC0 1.0
+/// @brief Compares the trie, critbit, and flat engines on hashed string keys. Build with optimizations together with dict.cpp, e.g. c++ -std=c++11 -O2 bench/engines.cpp dict.cpp -o bench_engines, and run with the number of keys as argument.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "../dict.h"
+
+typedef std::chrono::steady_clock clock_type;
+
+struct critbit_policy : cc0::dict_policy
+{
+	typedef cc0::critbit_engine engine;
+};
+
+struct flat_policy : cc0::dict_policy
+{
+	typedef cc0::flat_engine engine;
+};
+
+/// @brief Returns the average number of nanoseconds per operation between two points in time.
+static double ns_per_op(clock_type::time_point a, clock_type::time_point b, uint64_t ops)
+{
+	return std::chrono::duration<double, std::nano>(b - a).count() / double(ops);
+}
+
+/// @brief Scrambles a number, so that keys are looked up in an order unrelated to the order they were inserted in.
+static uint64_t scramble(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+template < typename policy_t >
+static void run(const char *name, const std::vector< cc0::key<const char*> > &keys, const std::vector< cc0::key<const char*> > &missing)
+{
+	const uint64_t n = keys.size();
+	const uint64_t q = 4999936; // A multiple of the batch size.
+	cc0::dict<cc0::key<const char*>, uint64_t, policy_t> d;
+	std::vector< cc0::key<const char*> > queries;
+	std::vector<uint64_t*> out(256);
+	uint64_t sum = 0;
+
+	for (uint64_t i = 0; i < q; ++i) {
+		queries.push_back(keys[scramble(i) % n]);
+	}
+
+	const clock_type::time_point t0 = clock_type::now();
+	for (uint64_t i = 0; i < n; ++i) {
+		d(keys[i]) = i;
+	}
+	const clock_type::time_point t1 = clock_type::now();
+	for (uint64_t i = 0; i < q; ++i) {
+		sum += *d[queries[i]];
+	}
+	const clock_type::time_point t2 = clock_type::now();
+	for (uint64_t i = 0; i < q; ++i) {
+		sum += d[missing[i % missing.size()]] != nullptr ? 1 : 0;
+	}
+	const clock_type::time_point t3 = clock_type::now();
+	for (uint64_t i = 0; i < q; i += out.size()) {
+		d.lookup_batch(&queries[i], out.size(), out.data());
+		for (uint64_t j = 0; j < out.size(); ++j) {
+			sum += *out[j];
+		}
+	}
+	const clock_type::time_point t4 = clock_type::now();
+	const double used = double(d.used_bytes()) / 1e6;
+	for (uint64_t i = 0; i < n; i += 2) {
+		d.remove(keys[i]);
+	}
+	const clock_type::time_point t5 = clock_type::now();
+
+	std::printf(
+		"%-8s n=%-9llu insert %5.0f  hit %5.0f  miss %5.0f  lookup_batch %5.0f  remove %5.0f ns  used %7.1f MB (%llu)\n",
+		name, (unsigned long long)n,
+		ns_per_op(t0, t1, n), ns_per_op(t1, t2, q), ns_per_op(t2, t3, q), ns_per_op(t3, t4, q), ns_per_op(t4, t5, n / 2),
+		used, (unsigned long long)(sum % 7)
+	);
+}
+
+int main(int argc, char **argv)
+{
+	const uint64_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+	std::vector< cc0::key<const char*> > keys;
+	std::vector< cc0::key<const char*> > missing;
+	char buffer[64];
+	for (uint64_t i = 0; i < n; ++i) {
+		std::snprintf(buffer, sizeof(buffer), "user:%llu", (unsigned long long)i);
+		keys.push_back(cc0::key<const char*>(buffer));
+	}
+	for (uint64_t i = 0; i < 1000000; ++i) {
+		std::snprintf(buffer, sizeof(buffer), "absent:%llu", (unsigned long long)i);
+		missing.push_back(cc0::key<const char*>(buffer));
+	}
+	run<cc0::dict_policy>("trie", keys, missing);
+	run<critbit_policy>("critbit", keys, missing);
+	run<flat_policy>("flat", keys, missing);
+	return 0;
+}
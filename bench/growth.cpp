@@ -0,0 +1,57 @@
+/// @file
+/// @author github.com/SirJonthe
+/// @date 2023
+/// @copyright Public domain.
+/// @license CC0 1.0
+/// @brief Compares how the time to fill a dictionary scales with the number of keys under geometric and linear growth. Build with optimizations together with dict.cpp, e.g. c++ -std=c++11 -O2 bench/growth.cpp dict.cpp -o bench_growth, and run with the largest number of keys as argument.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "../dict.h"
+
+typedef std::chrono::steady_clock clock_type;
+
+struct linear_policy : cc0::dict_policy
+{
+	typedef cc0::linear_growth growth;
+};
+
+/// @brief Returns the number of milliseconds since a point in time.
+static double ms_since(clock_type::time_point t)
+{
+	return std::chrono::duration<double, std::milli>(clock_type::now() - t).count();
+}
+
+/// @brief Fills a single dictionary.
+template < typename policy_t >
+static double load(uint64_t n)
+{
+	const clock_type::time_point t = clock_type::now();
+	cc0::dict<uint64_t, uint64_t, policy_t> d;
+	for (uint64_t i = 0; i < n; ++i) {
+		d(i * 0x9E3779B97F4A7C15ULL) = i;
+	}
+	return ms_since(t);
+}
+
+int main(int argc, char **argv)
+{
+	const uint64_t max_n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 256000;
+	double prev_geometric = 0.0;
+	double prev_linear = 0.0;
+	// NOTE: Doubling the number of keys should roughly double the time under geometric growth, and roughly quadruple it under linear growth.
+	for (uint64_t n = 4000; n <= max_n; n *= 2) {
+		const double geometric = load<cc0::dict_policy>(n);
+		const double linear = load<linear_policy>(n);
+		std::printf(
+			"n=%-9llu geometric %9.1f ms (x%4.1f)  linear %9.1f ms (x%4.1f)\n",
+			(unsigned long long)n,
+			geometric, prev_geometric > 0.0 ? geometric / prev_geometric : 0.0,
+			linear, prev_linear > 0.0 ? linear / prev_linear : 0.0
+		);
+		prev_geometric = geometric;
+		prev_linear = linear;
+	}
+	return 0;
+}
@@ -0,0 +1,67 @@
+/// @file
+/// @author github.com/SirJonthe
+/// @date 2023
+/// @copyright Public domain.
+/// @license CC0 1.0
+/// @brief Measures random look-ups that hit and miss in a large dictionary. Build with optimizations together with dict.cpp, e.g. c++ -std=c++11 -O2 bench/lookup.cpp dict.cpp -o bench_lookup, and run with the number of keys as argument.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "../dict.h"
+
+typedef std::chrono::steady_clock clock_type;
+
+/// @brief Returns the average number of nanoseconds per operation between two points in time.
+static double ns_per_op(clock_type::time_point a, clock_type::time_point b, uint64_t ops)
+{
+	return std::chrono::duration<double, std::nano>(b - a).count() / double(ops);
+}
+
+/// @brief Scrambles a number, so that keys are spread over the whole key space and looked up in an order unrelated to the order they were inserted in.
+static uint64_t scramble(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+int main(int argc, char **argv)
+{
+	const uint64_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+	const uint64_t q = 10000000;
+	cc0::dict<uint64_t, uint64_t> d;
+	std::vector<uint64_t> hits;
+	std::vector<uint64_t> misses;
+	uint64_t sum = 0;
+
+	// NOTE: Keys i < n are present, keys i >= n are absent.
+	for (uint64_t i = 0; i < q; ++i) {
+		hits.push_back(scramble(scramble(i + 1) % n));
+		misses.push_back(scramble(n + i));
+	}
+
+	const clock_type::time_point t0 = clock_type::now();
+	for (uint64_t i = 0; i < n; ++i) {
+		d(scramble(i)) = i;
+	}
+	const clock_type::time_point t1 = clock_type::now();
+	for (uint64_t i = 0; i < q; ++i) {
+		sum += *d[hits[i]];
+	}
+	const clock_type::time_point t2 = clock_type::now();
+	for (uint64_t i = 0; i < q; ++i) {
+		sum += d[misses[i]] != nullptr ? 1 : 0;
+	}
+	const clock_type::time_point t3 = clock_type::now();
+
+	std::printf(
+		"n=%-9llu insert %5.0f  hit %5.0f  miss %5.0f ns (%llu)\n",
+		(unsigned long long)n,
+		ns_per_op(t0, t1, n), ns_per_op(t1, t2, q), ns_per_op(t2, t3, q),
+		(unsigned long long)(sum % 7)
+	);
+	return 0;
+}
@@ -7,7 +7,34 @@
 #ifndef CC0_DICT_H_INCLUDED__
 #define CC0_DICT_H_INCLUDED__
 
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define CC0_DICT_PREFETCH(address) __builtin_prefetch(address)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <xmmintrin.h>
+	#define CC0_DICT_PREFETCH(address) _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0)
+#else
+	#define CC0_DICT_PREFETCH(address)
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define CC0_DICT_SSE2 1
+#else
+	#define CC0_DICT_SSE2 0
+#endif
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	#define CC0_DICT_BIG_ENDIAN 1
+#else
+	#define CC0_DICT_BIG_ENDIAN 0
+#endif
 
 namespace cc0
 {
@@ -18,6 +45,10 @@ namespace cc0
 		/// @return The number of characters in the string.
 		uint64_t str_count(const char *s);
 
+		/// @brief Prints a message to stderr and aborts the program. Used for errors that leave a dictionary in a state it can not recover from.
+		/// @param msg The message.
+		[[noreturn]] void fatal(const char *msg);
+
 		/// @brief A 64-bit FNV1a hasher.
 		class fnv1a64
 		{
@@ -83,6 +114,211 @@ namespace cc0
 			/// @brief Returns the current state of the digest.
 			operator uint64_t( void ) const;
 		};
+
+		/// @brief Hashes the bytes of a key so that all bits of the hash depend on all bits of the key. Faster than fnv1a64, since the key is mixed eight bytes at a time.
+		/// @tparam key_t The type of the key.
+		/// @param k The key.
+		/// @return The hash.
+		template < typename key_t >
+		uint64_t hash(const key_t &k);
+
+		/// @brief Checks whether a position occurs in a list of positions.
+		/// @param p The position.
+		/// @return False.
+		constexpr bool has_position(uint8_t p);
+
+		/// @brief Checks whether a position occurs in a list of positions.
+		/// @param p The position.
+		/// @param first The first position in the list.
+		/// @param rest The rest of the positions in the list.
+		/// @return True if p is in the list.
+		template < typename... rest_t >
+		constexpr bool has_position(uint8_t p, uint8_t first, rest_t... rest);
+
+		/// @brief Checks whether a list of positions is a permutation of the positions of a key.
+		/// @param size The number of bytes in the key.
+		/// @return True.
+		constexpr bool is_permutation(uint64_t size);
+
+		/// @brief Checks whether a list of positions is a permutation of the positions of a key, i.e. that every position is within the key, and no position occurs twice. Combined with a list as long as the key, every position then occurs exactly once.
+		/// @param size The number of bytes in the key.
+		/// @param first The first position in the list.
+		/// @param rest The rest of the positions in the list.
+		/// @return True if the list is a permutation.
+		template < typename... rest_t >
+		constexpr bool is_permutation(uint64_t size, uint8_t first, rest_t... rest);
+
+		/// @brief Allocates uninitialized memory for a number of elements. No elements are constructed.
+		/// @tparam type_t The type of the elements.
+		/// @tparam alloc_t The source of memory. See heap_allocator.
+		/// @param size The number of elements.
+		/// @return The memory.
+		template < typename type_t, typename alloc_t >
+		type_t *allocate_pool(uint64_t size);
+
+		/// @brief Frees memory returned by allocate_pool. Elements still in the memory are not destroyed.
+		/// @tparam type_t The type of the elements.
+		/// @tparam alloc_t The source of memory. See heap_allocator.
+		/// @param vals The memory, as returned by allocate_pool. May be null.
+		/// @param size The number of elements, as passed to allocate_pool.
+		template < typename type_t, typename alloc_t >
+		void free_pool(type_t *vals, uint64_t size);
+
+		/// @brief A basic array type for internal use. Only the elements in use are constructed. The rest of the pool is uninitialized memory.
+		/// @tparam type_t The type of the array.
+		/// @tparam growth_t The strategy used to grow the pool. See geometric_growth.
+		/// @tparam alloc_t The source of memory for the pool. See heap_allocator.
+		template < typename type_t, typename growth_t, typename alloc_t >
+		class array
+		{
+		private:
+			type_t   *m_vals;
+			uint64_t  m_size;
+			uint64_t  m_pool;
+			uint64_t  m_growth;
+
+		public:
+			explicit array(uint64_t growth = 1);
+			array(const array &a);
+			array(array &&a) noexcept;
+			~array( void );
+			array &operator=(const array &a);
+			array &operator=(array &&a) noexcept;
+			void          destroy( void );
+			void          create(uint64_t size);
+			void          reserve(uint64_t size);
+			void          resize(uint64_t size);
+			void          resize_pool(uint64_t size);
+			bool          shrink_pool(uint64_t &budget);
+			void          truncate(uint64_t size);
+			type_t       &add( void );
+			template < typename arg_t >
+			type_t       &add(arg_t &&arg);
+			uint64_t      size( void ) const;
+			uint64_t      pool_size( void ) const;
+			type_t       &operator[](uint64_t i);
+			const type_t &operator[](uint64_t i) const;
+			type_t       &first( void );
+			const type_t &first( void ) const;
+			type_t       &last( void );
+			const type_t &last( void ) const;
+		};
+
+		/// @brief The storage of the key-value pairs of a dictionary, with the key and value of each pair next to each other in memory. Removed entries are linked into a doubly linked free list and reused by later insertions.
+		/// @tparam key_t The type of the key.
+		/// @tparam value_t The type of the value.
+		/// @tparam policy_t The policies used to configure the dictionary. See dict_policy.
+		template < typename key_t, typename value_t, typename policy_t >
+		class store
+		{
+		private:
+			/// @brief A key and its value.
+			struct pair
+			{
+				key_t   k; // The full key.
+				value_t v; // The value.
+			};
+
+			/// @brief A key-value pair. The key and value are only constructed while the entry is in use, and are destroyed when the entry is put in the free list.
+			struct entry
+			{
+				union
+				{
+					pair     kv;   // The key and value. Only valid for entries in use.
+					uint64_t prev; // The position of the previous entry in the free list plus one, or zero if this is the first entry. Only valid for entries in the free list. Shares memory with the key and value so that entries do not grow.
+				};
+				uint64_t refs : 1;  // The number of references to this entry from tables. Zero if the entry is in the free list.
+				uint64_t next : 63; // The position of the next entry in the free list plus one, or zero if this is the last entry. Only valid for entries in the free list.
+
+				explicit entry(const key_t &key);
+				entry(const entry &e);
+				entry(entry &&e);
+				~entry( void );
+				entry &operator=(const entry&) = delete;
+			};
+
+		private:
+			array<entry, typename policy_t::growth, typename policy_t::allocator> m_entries;
+			uint64_t                                                              m_free; // The position of the head of the free list plus one, or zero if the list is empty.
+			uint64_t                                                              m_size;
+
+		private:
+			void link(uint64_t e);
+			void unlink(uint64_t e);
+
+		public:
+			store( void );
+			store(const store&) = default;
+			store(store &&s) noexcept;
+			store &operator=(const store&) = default;
+			store &operator=(store &&s) noexcept;
+			uint64_t       add(const key_t &k);
+			void           remove(uint64_t e);
+			void           clear( void );
+			void           reserve(uint64_t entries);
+			bool           pack(uint64_t &from, uint64_t &to, uint64_t &budget);
+			void           relocate(uint64_t from, uint64_t to);
+			bool           cmp(uint64_t e, const key_t &k) const;
+			const key_t   &key(uint64_t e) const;
+			value_t       &value(uint64_t e);
+			const value_t &value(uint64_t e) const;
+			void           prefetch(uint64_t e) const;
+			template < typename func_t >
+			void           for_each(func_t &f);
+			template < typename func_t >
+			void           for_each(func_t &f) const;
+			uint64_t       size( void ) const;
+			uint64_t       allocated_bytes( void ) const;
+			uint64_t       used_bytes( void ) const;
+		};
+
+		/// @brief The storage of the key-value pairs of a dictionary, with keys, values, and the liveness of each pair stored in separate arrays. Removed entries are reused by later insertions.
+		/// @tparam key_t The type of the key.
+		/// @tparam value_t The type of the value.
+		/// @tparam policy_t The policies used to configure the dictionary. See dict_policy.
+		template < typename key_t, typename value_t, typename policy_t >
+		class column_store
+		{
+		private:
+			array<key_t, typename policy_t::growth, typename policy_t::allocator>    m_keys;
+			array<value_t, typename policy_t::growth, typename policy_t::allocator>  m_values;
+			array<uint64_t, typename policy_t::growth, typename policy_t::allocator> m_live; // One bit per entry. Set if the entry is in use.
+			array<uint64_t, typename policy_t::growth, typename policy_t::allocator> m_free; // The words of the liveness column that have entries not in use.
+			array<uint64_t, typename policy_t::growth, typename policy_t::allocator> m_slot; // The position of each word of the liveness column in m_free plus one, or zero if the word is not in m_free.
+			uint64_t                                                                 m_size;
+
+		private:
+			uint64_t        free_bits(uint64_t w) const;
+			void            link(uint64_t w);
+			void            unlink(uint64_t w);
+			uint64_t        take( void );
+			static uint64_t lowest(uint64_t mask);
+
+		public:
+			column_store( void );
+			column_store(const column_store&) = default;
+			column_store(column_store &&s) noexcept;
+			column_store &operator=(const column_store&) = default;
+			column_store &operator=(column_store &&s) noexcept;
+			uint64_t       add(const key_t &k);
+			void           remove(uint64_t e);
+			void           clear( void );
+			void           reserve(uint64_t entries);
+			bool           pack(uint64_t &from, uint64_t &to, uint64_t &budget);
+			void           relocate(uint64_t from, uint64_t to);
+			bool           cmp(uint64_t e, const key_t &k) const;
+			const key_t   &key(uint64_t e) const;
+			value_t       &value(uint64_t e);
+			const value_t &value(uint64_t e) const;
+			void           prefetch(uint64_t e) const;
+			template < typename func_t >
+			void           for_each(func_t &f);
+			template < typename func_t >
+			void           for_each(func_t &f) const;
+			uint64_t       size( void ) const;
+			uint64_t       allocated_bytes( void ) const;
+			uint64_t       used_bytes( void ) const;
+		};
 	}
 
 	/// @brief A generic key generator.
@@ -113,37 +349,371 @@ namespace cc0
 		key(const char *v, uint64_t num_chars);
 	};
 
-	/// @brief A dictionary/hash table/map type where an arbitary key type can be used as an index to find a particular value stored in the data structure.
-	/// @tparam key_t The type of the key used to access values. Default behavior is to compare keys using a bytewise comparison.
-	/// @tparam value_t The type of the value to be stored in the table.
-	/// @note This means that keys containing pointers to data most likely will fail equality tests even though the data being pointed to is the same between two keys if they merely are copies. A common issue would be to use std::string as a key (use const char* as a key since constant strings are stored globally in the binary in C and C++). For the general purpose use a custom digest class as a key instead, or provide your own custom comparison function.
-	/// @note Due to how this table is implemented, look up is O(n) in time complexity, where n is the number of bytes in the key type. However, for many cases, using a good key will result in a hit in just a few iterations. 
-	template < typename key_t, typename value_t >
-	class dict
+	/// @brief A growth strategy that doubles the capacity of internal storage whenever it runs out of space. Insertion is amortized O(1).
+	struct geometric_growth
+	{
+		/// @brief Computes the new capacity of a full pool.
+		/// @param pool The current capacity of the pool.
+		/// @param step The minimum number of elements to grow the pool by.
+		/// @return The new capacity of the pool.
+		static uint64_t grow(uint64_t pool, uint64_t step);
+	};
+
+	/// @brief A growth strategy that increases the capacity of internal storage by a fixed number of elements whenever it runs out of space.
+	/// @note Wastes less memory than geometric growth, but inserting n values copies O(n^2) elements.
+	struct linear_growth
+	{
+		/// @brief Computes the new capacity of a full pool.
+		/// @param pool The current capacity of the pool.
+		/// @param step The number of elements to grow the pool by.
+		/// @return The new capacity of the pool.
+		static uint64_t grow(uint64_t pool, uint64_t step);
+	};
+
+	/// @brief A growth strategy that allocates internal storage in chunks of a fixed size, and adds a chunk whenever it runs out of space. Elements never move once added, so growing never copies elements, and pointers to values stay valid until the values are removed.
+	/// @note Every array in use takes up at least one chunk, which makes this a poor fit for small dictionaries. Accessing an element goes through a directory of chunks. Tables of the trie engine still move when they change size, so this does not keep pointers to values stable in combination with inline_layout.
+	struct segmented_growth
+	{
+		static const uint64_t CHUNK_BYTES = 65536; // The maximum size of a chunk in bytes. Chunks hold the largest power of two number of elements that fits, but at least one element.
+	};
+
+	/// @brief An allocator that takes the memory of internal storage from the global heap.
+	struct heap_allocator
+	{
+		/// @brief Allocates uninitialized memory.
+		/// @param bytes The number of bytes to allocate.
+		/// @param align The alignment of the memory in bytes. Must be a power of two.
+		/// @return The memory.
+		static void *allocate(uint64_t bytes, uint64_t align);
+
+		/// @brief Frees memory returned by allocate.
+		/// @param p The memory.
+		/// @param bytes The number of bytes passed to allocate.
+		/// @param align The alignment passed to allocate.
+		static void deallocate(void *p, uint64_t bytes, uint64_t align);
+	};
+
+	/// @brief An arena that hands out memory by bumping a pointer through large blocks, and frees all of it at once. Allocating is a few instructions, and freeing individual allocations is not possible.
+	class bump_arena
 	{
 	private:
-		/// @brief A basic array type for internal use.
+		/// @brief The header of a block of memory.
+		struct block
+		{
+			block    *next; // The previously allocated block.
+			uint64_t  size; // The size of the block in bytes, including the header.
+		};
+
+	private:
+		block    *m_blocks; // The most recently allocated block, which is also the block the cursor points into.
+		uint8_t  *m_at;
+		uint8_t  *m_end;
+		uint64_t  m_block_size;
+		uint64_t  m_allocated;
+
+	private:
+		/// @brief Allocates a block from the global heap.
+		/// @param size The size of the block in bytes.
+		/// @return The block.
+		static block *new_block(uint64_t size);
+
+	public:
+		/// @brief Creates an empty arena.
+		/// @param block_size The size in bytes of the blocks the arena allocates from the global heap. Allocations larger than a quarter of this get a block of their own.
+		explicit bump_arena(uint64_t block_size = 1 << 20);
+
+		bump_arena(const bump_arena&) = delete;
+		bump_arena &operator=(const bump_arena&) = delete;
+
+		/// @brief Frees all memory of the arena.
+		~bump_arena( void );
+
+		/// @brief Allocates uninitialized memory.
+		/// @param bytes The number of bytes to allocate.
+		/// @param align The alignment of the memory in bytes. Must be a power of two.
+		/// @return The memory.
+		void *allocate(uint64_t bytes, uint64_t align);
+
+		/// @brief Frees all memory handed out by the arena. Keeps one block so that the arena can be reused without going to the global heap.
+		/// @note Anything that still uses memory from the arena, such as dictionaries, must be destroyed first.
+		void clear( void );
+
+		/// @brief Returns the number of bytes the arena has allocated from the global heap.
+		/// @return The number of bytes.
+		uint64_t allocated_bytes( void ) const;
+	};
+
+	/// @brief An allocator that takes the memory of internal storage from an arena, and never frees it. The memory is instead freed all at once when the arena is cleared.
+	/// @tparam arena_t A function that returns the arena to allocate from, such as a function returning a thread-local arena for the current request.
+	/// @note Dictionaries must be destroyed before their arena is cleared. Storage that grows leaves its old memory behind in the arena, so prefer segmented_growth, or reserve enough capacity up front, for dictionaries that grow large.
+	/// @note Other sources of memory, such as pools of huge pages, are used by supplying a type with the same static functions as this.
+	template < bump_arena &(*arena_t)( void ) >
+	struct arena_allocator
+	{
+		/// @brief Allocates uninitialized memory.
+		/// @param bytes The number of bytes to allocate.
+		/// @param align The alignment of the memory in bytes. Must be a power of two.
+		/// @return The memory.
+		static void *allocate(uint64_t bytes, uint64_t align);
+
+		/// @brief Does nothing. The memory is freed when the arena is cleared.
+		/// @param p The memory.
+		/// @param bytes The number of bytes passed to allocate.
+		/// @param align The alignment passed to allocate.
+		static void deallocate(void *p, uint64_t bytes, uint64_t align);
+	};
+
+	/// @brief Packs a table index and its type into a single 32-bit word. This halves the size of a table compared to 64-bit indices, but limits the dictionary to fewer than 2^30 values and 2^28 tables of each size, or 2^32 values for the flat engine.
+	/// @warning Exceeding the limits aborts the program with a message, so only use this for dictionaries known to stay small.
+	struct index32
+	{
+		typedef uint32_t word_t;
+		static const uint64_t FINGERPRINT_BITS = 0; // The number of upper bits of an index that hold a fingerprint of the key of the value it points to. The trie engine rejects most failed look-ups by the fingerprint without reading the key.
+	};
+
+	/// @brief Packs a table index and its type into a single 64-bit word, along with a 16-bit fingerprint of the key of the value it points to. The fingerprint rejects most failed look-ups without reading the key. Limits the dictionary to fewer than 2^46 values.
+	struct index64
+	{
+		typedef uint64_t word_t;
+		static const uint64_t FINGERPRINT_BITS = 16; // The number of upper bits of an index that hold a fingerprint of the key of the value it points to. The trie engine rejects most failed look-ups by the fingerprint without reading the key.
+	};
+
+	/// @brief A key order that walks the bytes of a key in the order they are stored in memory. This is fast, but keys that share many bytes, or only differ in their last bytes, result in deep tries.
+	struct memory_order
+	{
+		/// @brief The sequence of bytes walked by the dictionary to find the value of a key.
+		/// @tparam key_t The key type.
+		template < typename key_t >
+		class path
+		{
+		private:
+			const uint8_t *m_bytes;
+
+		public:
+			static const uint64_t DEPTH = sizeof(key_t); // The number of bytes in the path.
+
+			/// @brief Creates an empty path.
+			path( void );
+
+			/// @brief Creates the path of a key.
+			/// @param k The key. Must outlive the path.
+			explicit path(const key_t &k);
+
+			/// @brief Returns a byte of the path.
+			/// @param level The position of the byte in the path.
+			/// @return The byte.
+			uint8_t operator[](uint64_t level) const;
+		};
+	};
+
+	/// @brief A key order that walks the bytes of a key from the last byte in memory to the first. Suits keys whose last bytes vary the most, such as big-endian integers.
+	struct reverse_order
+	{
+		/// @brief The sequence of bytes walked by the dictionary to find the value of a key.
+		/// @tparam key_t The key type.
+		template < typename key_t >
+		class path
+		{
+		private:
+			const uint8_t *m_bytes;
+
+		public:
+			static const uint64_t DEPTH = sizeof(key_t); // The number of bytes in the path.
+
+			/// @brief Creates an empty path.
+			path( void );
+
+			/// @brief Creates the path of a key.
+			/// @param k The key. Must outlive the path.
+			explicit path(const key_t &k);
+
+			/// @brief Returns a byte of the path.
+			/// @param level The position of the byte in the path.
+			/// @return The byte.
+			uint8_t operator[](uint64_t level) const;
+		};
+	};
+
+	/// @brief A key order that walks the bytes of an integer key from the most significant byte to the least significant byte regardless of the endianness of the platform. Suits keys whose most significant bytes vary the most, such as aligned pointers and timestamps whose lower bits are noisy.
+	struct msb_first_order
+	{
+		/// @brief The sequence of bytes walked by the dictionary to find the value of a key.
+		/// @tparam key_t The key type.
+		template < typename key_t >
+		class path
+		{
+		private:
+			const uint8_t *m_bytes;
+
+		public:
+			static const uint64_t DEPTH = sizeof(key_t); // The number of bytes in the path.
+
+			/// @brief Creates an empty path.
+			path( void );
+
+			/// @brief Creates the path of a key.
+			/// @param k The key. Must outlive the path.
+			explicit path(const key_t &k);
+
+			/// @brief Returns a byte of the path.
+			/// @param level The position of the byte in the path.
+			/// @return The byte.
+			uint8_t operator[](uint64_t level) const;
+		};
+	};
+
+	/// @brief A key order that walks the bytes of a key in an explicit order. Use this to branch on the bytes of a composite key that vary the most first.
+	/// @tparam positions The position in memory of each byte of the key in the order they should be walked. Must contain every position of the key exactly once.
+	template < uint8_t... positions >
+	struct permuted_order
+	{
+		/// @brief The sequence of bytes walked by the dictionary to find the value of a key.
+		/// @tparam key_t The key type.
+		template < typename key_t >
+		class path
+		{
+		private:
+			static_assert(sizeof...(positions) == sizeof(key_t), "The permutation must contain one position per key byte.");
+			static_assert(cc0::internal::is_permutation(sizeof(key_t), positions...), "The permutation must contain every position of the key exactly once.");
+			static const uint8_t POSITIONS[sizeof...(positions)];
+			const uint8_t *m_bytes;
+
+		public:
+			static const uint64_t DEPTH = sizeof(key_t); // The number of bytes in the path.
+
+			/// @brief Creates an empty path.
+			path( void );
+
+			/// @brief Creates the path of a key.
+			/// @param k The key. Must outlive the path.
+			explicit path(const key_t &k);
+
+			/// @brief Returns a byte of the path.
+			/// @param level The position of the byte in the path.
+			/// @return The byte.
+			uint8_t operator[](uint64_t level) const;
+		};
+	};
+
+	/// @brief A key order that first walks the bytes of a 64-bit hash of the key, and then the bytes of the key itself. Depth and memory usage of the dictionary are then more or less independent of how keys are distributed, at the cost of hashing the key on every access.
+	struct hashed_order
+	{
+		/// @brief The sequence of bytes walked by the dictionary to find the value of a key.
+		/// @tparam key_t The key type.
+		template < typename key_t >
+		class path
+		{
+		private:
+			uint64_t       m_hash;
+			const uint8_t *m_bytes;
+
+		public:
+			static const uint64_t DEPTH = sizeof(uint64_t) + sizeof(key_t); // The number of bytes in the path. The key bytes follow the hash so that keys with colliding hashes still have distinct paths.
+
+			/// @brief Creates an empty path.
+			path( void );
+
+			/// @brief Creates the path of a key.
+			/// @param k The key. Must outlive the path.
+			explicit path(const key_t &k);
+
+			/// @brief Returns a byte of the path.
+			/// @param level The position of the byte in the path.
+			/// @return The byte.
+			uint8_t operator[](uint64_t level) const;
+		};
+	};
+
+	/// @brief A storage layout that stores each key next to its value. A successful look-up reads both from the same cache line.
+	struct interleaved_layout
+	{
+		static const bool INLINE = false; // Whether the trie engine stores keys and values directly in its tables.
+
+		template < typename key_t, typename value_t, typename policy_t >
+		using type = cc0::internal::store<key_t, value_t, policy_t>;
+	};
+
+	/// @brief A storage layout that stores keys, values, and the liveness of entries in separate arrays. Failed key comparisons only read keys, and values are contiguous in memory.
+	struct columnar_layout
+	{
+		static const bool INLINE = false; // Whether the trie engine stores keys and values directly in its tables.
+
+		template < typename key_t, typename value_t, typename policy_t >
+		using type = cc0::internal::column_store<key_t, value_t, policy_t>;
+	};
+
+	/// @brief A storage layout that stores keys and values of up to 8 bytes each directly in the slots of the tables of the trie engine. A successful look-up then reads the value from the same cache line as the index that leads to it, without visiting separate storage. Larger keys or values, keys or values that are not trivially copyable and trivially destructible, and other engines, are stored as in interleaved_layout.
+	/// @note Every slot grows by the size of a key and a value, including slots that refer to other tables.
+	struct inline_layout
+	{
+		static const bool INLINE = true; // Whether the trie engine stores keys and values directly in its tables.
+
+		template < typename key_t, typename value_t, typename policy_t >
+		using type = cc0::internal::store<key_t, value_t, policy_t>;
+	};
+
+	namespace internal
+	{
+		/// @brief Returns the base 2 logarithm of a number, rounded down.
+		/// @param n The number.
+		/// @return The base 2 logarithm of the number, rounded down, or 0 if the number is 0.
+		constexpr uint64_t floor_log2(uint64_t n)
+		{
+			return n > 1 ? 1 + floor_log2(n >> 1) : 0;
+		}
+
+		/// @brief Raises a number to a non-negative integer power.
+		/// @param x The number.
+		/// @param e The power.
+		/// @return x to the power of e.
+		inline double power(double x, uint64_t e)
+		{
+			double r = 1.0;
+			for (; e > 0; e >>= 1, x *= x) {
+				if ((e & 1) != 0) {
+					r *= x;
+				}
+			}
+			return r;
+		}
+
+		/// @brief An array that stores its elements in chunks of a fixed size. Growing the array adds chunks, and never moves elements. See segmented_growth.
 		/// @tparam type_t The type of the array.
-		template < typename type_t >
-		class array
+		/// @tparam alloc_t The source of memory for the chunks. See heap_allocator.
+		template < typename type_t, typename alloc_t >
+		class array<type_t, cc0::segmented_growth, alloc_t>
 		{
 		private:
-			type_t   *m_vals;
+			static const uint64_t CHUNK_SHIFT = floor_log2(sizeof(type_t) < cc0::segmented_growth::CHUNK_BYTES ? cc0::segmented_growth::CHUNK_BYTES / sizeof(type_t) : 1);
+			static const uint64_t CHUNK_SIZE  = uint64_t(1) << CHUNK_SHIFT;
+			static const uint64_t CHUNK_MASK  = CHUNK_SIZE - 1;
+
+		private:
+			type_t  **m_chunks;
+			uint64_t  m_num_chunks;
+			uint64_t  m_dir_size; // The number of chunk pointers the directory has room for.
 			uint64_t  m_size;
-			uint64_t  m_pool;
-			uint64_t  m_growth;
+
+		private:
+			void add_chunk( void );
 
 		public:
 			explicit array(uint64_t growth = 1);
 			array(const array &a);
+			array(array &&a) noexcept;
 			~array( void );
 			array &operator=(const array &a);
+			array &operator=(array &&a) noexcept;
 			void          destroy( void );
 			void          create(uint64_t size);
 			void          reserve(uint64_t size);
 			void          resize(uint64_t size);
 			void          resize_pool(uint64_t size);
+			bool          shrink_pool(uint64_t &budget);
+			void          truncate(uint64_t size);
 			type_t       &add( void );
+			template < typename arg_t >
+			type_t       &add(arg_t &&arg);
 			uint64_t      size( void ) const;
 			uint64_t      pool_size( void ) const;
 			type_t       &operator[](uint64_t i);
@@ -154,538 +724,4452 @@ namespace cc0
 			const type_t &last( void ) const;
 		};
 
-		/// @brief An index into an array.
-		struct index
+		/// @brief A key-value pair stored directly in a table slot. Empty if disabled.
+		/// @tparam key_t The type of the key.
+		/// @tparam value_t The type of the value.
+		/// @tparam enabled_t Whether the slot has room for a key-value pair.
+		template < typename key_t, typename value_t, bool enabled_t >
+		struct inline_entry
 		{
-			enum {
-				NIL,  // Element has never been allocated before.
-				FREE, // Element has previously been allocated, but is no longer in use.
-				VAL,  // Element points to a value in the value array.
-				TAB   // Element points to a table in the table array.
-			} type;
-			uint64_t index;
+			bool           cmp(const key_t &k) const;
+			void           set(const key_t &k);
+			const key_t   *key( void ) const;
+			value_t       *value( void );
+			const value_t *value( void ) const;
 		};
 
-		/// @brief A hash table entry (key-value pair).
-		struct entry
+		template < typename key_t, typename value_t >
+		struct inline_entry<key_t, value_t, true>
 		{
-			key_t    k;    // The full key.
-			value_t  v;    // The value.
-			uint64_t refs; // The number of references to this entry from tables.
+			union { key_t   k; }; // Only constructed while the slot holds a value inline. Slots are copied bytewise.
+			union { value_t v; };
+
+			inline_entry( void );
+			bool           cmp(const key_t &k) const;
+			void           set(const key_t &k);
+			const key_t   *key( void ) const;
+			value_t       *value( void );
+			const value_t *value( void ) const;
 		};
 
-		static const uint64_t NUM_ENTRIES_IN_TABLE = uint64_t(uint8_t(-1)) + 1;
+		template < typename key_t, typename value_t, typename policy_t >
+		class trie;
+
+		template < typename key_t, typename value_t, typename policy_t >
+		class critbit;
+
+		template < typename key_t, typename value_t, typename policy_t >
+		class flat;
+	}
+
+	/// @brief An engine that walks keys one byte at a time through a trie of tables with up to 256 branches each. Look-ups visit few tables, at the cost of some memory per table.
+	struct trie_engine
+	{
+		template < typename key_t, typename value_t, typename policy_t >
+		using type = cc0::internal::trie<key_t, value_t, policy_t>;
+	};
+
+	/// @brief An engine that branches only on the bits at which keys differ. Uses exactly one small node per value, which makes it the most memory efficient engine for large keys, at the cost of visiting more nodes per look-up.
+	struct critbit_engine
+	{
+		template < typename key_t, typename value_t, typename policy_t >
+		using type = cc0::internal::critbit<key_t, value_t, policy_t>;
+	};
+
+	/// @brief An engine that hashes keys into an open-addressing hash table, probing 16 slots at a time. Suits keys that are already uniformly distributed, such as hashes, since a look-up usually only touches one group of slots and the value itself.
+	/// @note The table always doubles in size when growing, regardless of the growth policy. The growth policy still applies to the storage of values.
+	struct flat_engine
+	{
+		template < typename key_t, typename value_t, typename policy_t >
+		using type = cc0::internal::flat<key_t, value_t, policy_t>;
+	};
+
+	/// @brief The default policies used to configure a dictionary. Inherit from this type and override the relevant type definitions to customize the behavior of a dictionary.
+	struct dict_policy
+	{
+		typedef geometric_growth   growth;    // The strategy used to grow internal storage.
+		typedef heap_allocator     allocator; // The source of memory for internal storage.
+		typedef index64            index;     // The width of the indices stored in tables.
+		typedef memory_order       order;     // The order in which key bytes are walked. Distinct keys must have distinct paths.
+		typedef trie_engine        engine;    // The data structure used to find values.
+		typedef interleaved_layout layout;    // The memory layout of keys and values.
+	};
 
-		/// @brief A table of indices.
-		struct table
+	namespace internal
+	{
+		/// @brief A dictionary engine that walks keys one byte at a time through a trie of tables. Tables come in several sizes and skip key bytes that all of their values have in common.
+		/// @tparam key_t The type of the key.
+		/// @tparam value_t The type of the value.
+		/// @tparam policy_t The policies used to configure the dictionary. See dict_policy.
+		template < typename key_t, typename value_t, typename policy_t >
+		class trie
 		{
-			index    idx[NUM_ENTRIES_IN_TABLE]; // Indices to either the value array or table array.
-			uint64_t refs;                      // The number of in-use values in this table.
-		};
+		private:
+			template < typename type_t >
+			using array = cc0::internal::array<type_t, typename policy_t::growth, typename policy_t::allocator>;
 
-		static table &init_table(table &t);
+			typedef typename policy_t::index::word_t word_t;
+			typedef typename policy_t::order::template path<key_t> path;
 
-	private:
-		array<entry> m_vals;
-		array<table> m_tabs;
-		uint64_t     m_size;
+			static const bool INLINE = policy_t::layout::INLINE && sizeof(key_t) <= 8 && sizeof(value_t) <= 8 && std::is_trivially_copyable<key_t>::value && std::is_trivially_copyable<value_t>::value && std::is_trivially_destructible<key_t>::value && std::is_trivially_destructible<value_t>::value; // Whether values are stored directly in table slots. Slots are copied bytewise, so only trivial keys and values are.
+			static_assert(!INLINE || (std::is_trivially_destructible<key_t>::value && std::is_trivially_destructible<value_t>::value), "keys and values stored inline are never destroyed");
 
-	private:
-		template < typename type_t >
-		static const uint8_t *bytes(const type_t &t);
-		bool                  cmp(const key_t &a, const key_t &b) const;
-		const value_t        *lookup(const table &t, const key_t &k, uint64_t level) const;
-		value_t              *lookup(const table &t, const key_t &k, uint64_t level);
-		value_t              &lookup_or_alloc(uint64_t t, const key_t &k, uint64_t level);
-		value_t              &alloc(uint64_t t, const key_t &k, uint64_t level);
-		void                  remove(table &t, const key_t &k, uint64_t level);
-		uint64_t              prof_lookup(const table &t, const key_t &k, uint64_t level) const;
+			static const uint64_t WORD_BITS        = sizeof(word_t) * 8;
+			static const uint64_t FINGERPRINT_BITS = policy_t::index::FINGERPRINT_BITS;
+
+			/// @brief An index into an array. The type of the index is packed into the lower two bits of the word, a fingerprint of the key of the value into the upper FINGERPRINT_BITS bits, and the index into the bits in between. If values are stored inline, the index also holds the key and value.
+			struct index : inline_entry<key_t, value_t, INLINE>
+			{
+				enum {
+					NIL, // Element is not in use.
+					VAL, // Element points to a value in the value array.
+					TAB, // Element points to a table in a table array.
+					INL  // Element holds the key and value itself.
+				};
+				word_t w;
+
+				static index make(uint64_t type, uint64_t i, uint64_t fingerprint = 0);
+				uint64_t     type( void ) const;
+				uint64_t     at( void ) const;
+				uint64_t     fingerprint( void ) const;
+			};
+
+			static const uint64_t NUM_ENTRIES_IN_TABLE = uint64_t(uint8_t(-1)) + 1;
+			static const uint64_t NUM_PREFIX_BYTES     = 8;
+			static const uint64_t NUM_BATCH_LOOKUPS    = 16;
+
+			/// @brief The different sizes of tables. Tables grow into the next size when full, and shrink into the previous size when sparsely populated.
+			enum {
+				TAB4,  // Up to 4 indices, sorted by key byte.
+				TAB16, // Up to 16 indices, sorted by key byte.
+				TAB48, // Up to 48 indices, indirectly addressed by key byte.
+				TAB256 // One index per key byte.
+			};
+
+			/// @brief The header shared by all table sizes.
+			/// @note A table skips the key bytes that all values in the table have in common, and branches on the first key byte that differs. Only the first few skipped bytes are stored in the table. The rest are verified when comparing against the full key of a value.
+			struct head
+			{
+				uint16_t refs;                     // The number of in-use values and tables in this table.
+				uint32_t skip;                     // The number of key bytes skipped before the key byte the table branches on.
+				uint8_t  prefix[NUM_PREFIX_BYTES]; // The first skipped key bytes.
+			};
+
+			/// @brief A table of up to 4 indices.
+			struct table4
+			{
+				head    h;
+				uint8_t key[4]; // The key bytes of the occupied indices in ascending order.
+				index   idx[4]; // Indices to either the value array or a table array.
+			};
+
+			/// @brief A table of up to 16 indices.
+			struct table16
+			{
+				head    h;
+				uint8_t key[16]; // The key bytes of the occupied indices in ascending order.
+				index   idx[16]; // Indices to either the value array or a table array.
+			};
+
+			/// @brief A table of up to 48 indices.
+			struct table48
+			{
+				head    h;
+				uint8_t slot[NUM_ENTRIES_IN_TABLE]; // The position of the index for each key byte plus one, or zero if there is no index for the key byte.
+				index   idx[48];                    // Indices to either the value array or a table array.
+			};
+
+			/// @brief A table of indices.
+			struct table256
+			{
+				head  h;
+				index idx[NUM_ENTRIES_IN_TABLE]; // Indices to either the value array or a table array.
+			};
+
+		private:
+			typename policy_t::layout::template type<key_t, value_t, policy_t> m_vals;
+			array<table4>                                                      m_tab4;
+			array<table16>                                                     m_tab16;
+			array<table48>                                                     m_tab48;
+			array<table256>                                                    m_tab256;
+			index                                                              m_free[4]; // The heads of the doubly linked free lists of each table size. Free tables link to the next free table via their first index, and to the previous free table via their second index.
+			index                                                              m_root;
+			uint64_t                                                           m_size;
+
+		private:
+			static index          make_table(uint64_t size, uint64_t t);
+			static uint64_t       table_size(index t);
+			static uint64_t       table_at(index t);
+			static uint64_t       capacity(index t);
+			static void           init_table(table4 &t);
+			static void           init_table(table16 &t);
+			static void           init_table(table48 &t);
+			static void           init_table(table256 &t);
+			template < typename table_t >
+			static uint64_t       used_tables(const array<table_t> &tabs);
+			template < typename table_t >
+			static void           reserve_tables(array<table_t> &tabs, uint64_t n);
+			static void           estimate_level(uint64_t n, double buckets, double *tables);
+			static void           estimate_tables(uint64_t entries, uint64_t *tables);
+			static uint64_t       fit(uint64_t refs);
+			template < typename table_t >
+			static void           count_fit(const array<table_t> &tabs, uint64_t *tables);
+			index                 adopt(trie &src, index i, array<index> &queue);
+			index                *leaf_slot(const key_t &k);
+			index                *table_slot(index t);
+			bool                  pack_values(uint64_t &budget);
+			template < typename table_t >
+			bool                  pack_tables(array<table_t> &tabs, uint64_t size, uint64_t &budget);
+			template < typename trie_t, typename func_t >
+			static void           for_each(trie_t &d, func_t &f);
+			template < typename trie_t, typename tables_t, typename func_t >
+			static void           for_each_inline(trie_t &d, tables_t &tabs, uint64_t size, func_t &f);
+			template < typename trie_t, typename index_t, typename func_t >
+			static void           visit(trie_t &d, index_t &l, func_t &f);
+			head                 &get_head(index t);
+			const head           &get_head(index t) const;
+			template < typename table_t >
+			index                 new_table(array<table_t> &tabs, uint64_t size);
+			index                 new_table(uint64_t size);
+			template < typename table_t >
+			void                  free_table(array<table_t> &tabs, index t);
+			void                  free_table(index t);
+			template < typename table_t >
+			void                  unlink_table(array<table_t> &tabs, index t);
+			uint64_t              gather(index t, uint8_t *keys, index *idx) const;
+			void                  fill(index t, const uint8_t *keys, const index *idx, uint64_t count);
+			index                 build(uint64_t size, const uint8_t *keys, const index *idx, uint64_t count);
+			index                *locate(index t, uint8_t b);
+			const index          *locate(index t, uint8_t b) const;
+			index                 find(index t, uint8_t b) const;
+			void                  set(index t, uint8_t b, index i);
+			void                  erase(index t, uint8_t b);
+			index                 add(index t, uint8_t b, index i);
+			index                 shrink(index t);
+			index                 collapse(index t);
+			void                  set_prefix(index t, const uint8_t *prefix, uint64_t skip);
+			void                  set_prefix(index t, const path &k, uint64_t level, uint64_t skip);
+			void                  copy_prefix(index dst, index src);
+			index                 any_leaf(index t) const;
+			uint64_t              mismatch(index t, const path &k, uint64_t level) const;
+			index                 split(index t, const key_t &k, uint64_t f, const path &pk, uint64_t level, uint64_t p, index &l);
+			index                 leaf(const key_t &k, uint64_t f);
+			void                  release(index l);
+			bool                  cmp(const index &l, const key_t &k, uint64_t f) const;
+			const key_t          &key(const index &l) const;
+			value_t              &value(index &l);
+			const value_t        &value(const index &l) const;
+			value_t              &placed(index t, uint8_t b, index l);
+			static uint64_t       fingerprint(const key_t &k);
+			void                  prefetch(index i, uint8_t b, uint64_t f) const;
+			void                  replace(index t, uint8_t b, index i);
+			const value_t        *lookup(const key_t &k) const;
+			value_t              &lookup_or_alloc(const key_t &k);
+			value_t              &alloc(index parent, uint8_t pb, index i, const key_t &k, uint64_t f, const path &pk, uint64_t level);
+
+		public:
+			/// @brief Initializes the data structure. No memory is allocated until the first value is inserted.
+			trie( void );
+
+			/// @brief Copies a dictionary.
+			/// @param d The dictionary to copy.
+			trie(const trie &d);
+
+			/// @brief Moves data from one dictionary to another.
+			/// @param d The dictionary to move data from.
+			trie(trie &&d) noexcept;
+
+			/// @brief Copies a dictionary.
+			/// @param d The dictionary to copy.
+			/// @return A reference to self.
+			trie &operator=(const trie &d);
+
+			/// @brief Moves data from one dictionary to another.
+			/// @param d The dictionary to move data from.
+			/// @return A reference to self.
+			trie &operator=(trie &&d) noexcept;
+
+			/// @brief Returns the pointer to the value pointed to by the key. Null is returned if the key does not exist.
+			/// @param key The key.
+			/// @return The value pointed to by the key.
+			const value_t *operator[](const key_t &key) const;
+		
+			/// @brief Returns the pointer to the value pointed to by the key. Null is returned if the key does not exist.
+			/// @param key The key.
+			/// @return The value pointed to by the key.
+			value_t *operator[](const key_t &key);
+
+			/// @brief Looks up several keys at once. Since the look-ups are interleaved, the memory accesses of one look-up overlap with those of the others, which makes this faster than looking up the keys one at a time.
+			/// @param keys The keys.
+			/// @param n The number of keys.
+			/// @param out Receives the pointer to the value pointed to by each key, or null if the key does not exist. Must have room for n pointers.
+			void lookup_batch(const key_t *keys, uint64_t n, const value_t **out) const;
+
+			/// @brief Looks up several keys at once. Since the look-ups are interleaved, the memory accesses of one look-up overlap with those of the others, which makes this faster than looking up the keys one at a time.
+			/// @param keys The keys.
+			/// @param n The number of keys.
+			/// @param out Receives the pointer to the value pointed to by each key, or null if the key does not exist. Must have room for n pointers.
+			void lookup_batch(const key_t *keys, uint64_t n, value_t **out);
+
+			/// @brief Returns a reference to the value pointed to by the key. If the value does not exist, there will be a null pointer dereference, and possibly a crash.
+			/// @param key The key.
+			/// @return The reference to the value pointed to by the key.
+			/// @warning May crash the application if the value does not exist. Only use this function if you are sure the value exists.
+			const value_t &operator()(const key_t &key) const;
+
+			/// @brief Returns a reference to the value pointed to by the key. If the value does not exist, a new value will be created making this function always safe to call (the value returned may, however, not be initialized).
+			/// @param key The key.
+			/// @return The reference to the value pointed to by the key.
+			value_t &operator()(const key_t &key);
+
+			/// @brief Returns a reference to the value pointed to by the key. If the value does not exist, a new value will be created making this function always safe to call (the value returned may, however, not be initialized).
+			/// @param key The key.
+			/// @return The reference to the value pointed to by the key.
+			value_t &insert(const key_t &key);
+
+			/// @brief Removes a value with the specified key. If the value does not exist nothing will happen.
+			/// @param key The key.
+			void remove(const key_t &key);
+
+			/// @brief Removes all values. Memory is kept for reuse, so that filling the dictionary up to its previous size again does not allocate.
+			/// @note Takes constant time when keys and values are trivially destructible.
+			void clear( void );
+
+			/// @brief Allocates room for a number of values, and the tables needed to find them, so that inserting that many values does not reallocate memory. Values already in the dictionary are kept.
+			/// @param entries The number of values to make room for.
+			/// @param tables Optional. The number of tables to make room for. If zero, the number is estimated by estimate_tables. The tables are divided between table sizes as estimated for hashed keys.
+			void reserve(uint64_t entries, uint64_t tables = 0);
+
+			/// @brief Rebuilds the dictionary into storage of exactly the size needed, dropping removed values and unused tables. Tables are shrunk to the smallest size that fits their contents, and tables and values are renumbered breadth-first so that the upper levels of the trie sit together in memory.
+			/// @note Takes time and temporary memory proportional to the size of the dictionary. Pointers to values are invalidated.
+			void compact( void );
+
+			/// @brief Defragments storage a little at a time. Values and tables in use at the end of storage are moved into the holes left by removed values and tables, and storage that is no longer in use is freed. Calling this repeatedly converges towards the memory use of compact without a long pause.
+			/// @param budget The maximum number of values and tables to move or release.
+			/// @return True if there may be more to defragment, false if storage is packed.
+			/// @note Pointers to values are invalidated. Storage grown with geometric_growth or linear_growth is only reallocated once at most half of it is in use, and only if its contents fit in what is left of the budget, since reallocating moves all of them. Larger storage is left for compact to release. Storage grown with segmented_growth is released without moving anything.
+			bool defrag_step(uint64_t budget);
+
+			/// @brief Returns the total space, in bytes, allocated by the data structure.
+			/// @return  The total space, in bytes, allocated by the data structure.
+			uint64_t allocated_bytes( void ) const;
+
+			/// @brief Returns the total space, in bytes, used by the data structure.
+			/// @return The total space, in bytes, used by the data structure.
+			/// @note This calculation does not completely give an accurate picture as tables containing at least one value is still marked as in use, and not partially in use.
+			uint64_t used_bytes( void ) const;
+
+			/// @brief Returns the number of values stored in the data structure.
+			/// @return The number of values stored in the data structure.
+			uint64_t size( void ) const;
+
+			/// @brief Calls a function once for each key-value pair in the dictionary. Values are visited in the order they are stored in memory rather than in key order. Values stored directly in table slots are visited last, table by table.
+			/// @tparam func_t The type of the function, called as f(const key_t &key, value_t &value).
+			/// @param f The function.
+			/// @warning The dictionary must not be modified by the function, other than through the value passed to it.
+			template < typename func_t >
+			void for_each(func_t &&f);
+
+			/// @brief Calls a function once for each key-value pair in the dictionary. Values are visited in the order they are stored in memory rather than in key order. Values stored directly in table slots are visited last, table by table.
+			/// @tparam func_t The type of the function, called as f(const key_t &key, const value_t &value).
+			/// @param f The function.
+			template < typename func_t >
+			void for_each(func_t &&f) const;
+
+			/// @brief Counts the number of look-ups made to find the requested value at the key.
+			/// @param key The key.
+			/// @param tables Optional. Receives the number of tables visited to find the value, i.e. the depth of the value in the compressed trie. Since tables skip key bytes that their values have in common, this may be lower than the returned number of key bytes.
+			/// @return The position of the last key byte examined to find the value at the key plus one, i.e. the depth of the value in a trie without compression.
+			uint64_t prof_lookup(const key_t &key, uint64_t *tables = nullptr) const;
+
+			/// @brief Returns the number of tables currently allocated for the dictionary.
+			/// @return The number of tables currently allocated for the dictionary.
+			uint64_t table_count( void ) const;
+
+			/// @brief Estimates the number of tables allocated for a number of keys whose bytes are uniformly distributed, such as hashes, or any keys using hashed_order. The estimate is usually within a few percent of table_count after inserting the keys.
+			/// @param entries The number of keys.
+			/// @return The estimated number of tables.
+			static uint64_t estimate_tables(uint64_t entries);
+		};
+
+		/// @brief A dictionary engine that stores values in a crit-bit tree. Each node branches on the first bit at which the keys below it differ, so a dictionary of n values has exactly n - 1 nodes regardless of the size of the keys.
+		/// @tparam key_t The type of the key.
+		/// @tparam value_t The type of the value.
+		/// @tparam policy_t The policies used to configure the dictionary. See dict_policy.
+		template < typename key_t, typename value_t, typename policy_t >
+		class critbit
+		{
+		private:
+			template < typename type_t >
+			using array = cc0::internal::array<type_t, typename policy_t::growth, typename policy_t::allocator>;
+
+			typedef typename policy_t::index::word_t word_t;
+			typedef typename policy_t::order::template path<key_t> path;
+
+			/// @brief An index into an array. The type of the index is packed into the lower two bits of the word, and the index into the remaining upper bits.
+			struct index
+			{
+				enum {
+					NIL,  // Element is not in use.
+					VAL,  // Element points to a value in the value array.
+					NODE  // Element points to a node in the node array.
+				};
+				word_t w;
+
+				static index make(uint64_t type, uint64_t i);
+				uint64_t     type( void ) const;
+				uint64_t     at( void ) const;
+			};
+
+			/// @brief A branch on a single bit of the key path.
+			struct node
+			{
+				index    child[2]; // The subtrees where the bit is clear and set respectively. Free nodes link to the next and previous free node via their first and second child.
+				uint32_t bit;      // The position of the bit in the key path. Bits are numbered from the most significant bit of the first byte of the path. FREE if the node is in the free list.
+			};
+
+			static const uint64_t NUM_BATCH_LOOKUPS = 16;
+			static const uint32_t FREE              = uint32_t(-1); // Marks a node in the free list. Not a valid bit position.
+
+		private:
+			typename policy_t::layout::template type<key_t, value_t, policy_t> m_vals;
+			array<node>                                                        m_nodes;
+			index                                                              m_free; // The head of the doubly linked free list of nodes.
+			index                                                              m_root;
+
+		private:
+			static uint64_t       direction(const node &n, const path &k);
+			void                  prefetch(index i) const;
+			void                  replace(index n, uint64_t dir, index i);
+			index                 new_node(uint64_t bit);
+			void                  free_node(index n);
+			void                  unlink_node(index n);
+			index                 adopt(critbit &src, index i, array<index> &queue);
+			index                *leaf_slot(const key_t &k);
+			index                *node_slot(index n);
+			bool                  pack_values(uint64_t &budget);
+			bool                  pack_nodes(uint64_t &budget);
+			const value_t        *lookup(const key_t &k) const;
+			value_t              &lookup_or_alloc(const key_t &k);
+
+		public:
+			/// @brief Initializes the data structure. No memory is allocated until the first value is inserted.
+			critbit( void );
+
+			/// @brief Copies a dictionary.
+			/// @param d The dictionary to copy.
+			critbit(const critbit &d);
+
+			/// @brief Moves data from one dictionary to another.
+			/// @param d The dictionary to move data from.
+			critbit(critbit &&d) noexcept;
+
+			/// @brief Copies a dictionary.
+			/// @param d The dictionary to copy.
+			/// @return A reference to self.
+			critbit &operator=(const critbit &d);
+
+			/// @brief Moves data from one dictionary to another.
+			/// @param d The dictionary to move data from.
+			/// @return A reference to self.
+			critbit &operator=(critbit &&d) noexcept;
+
+			/// @brief Returns the pointer to the value pointed to by the key. Null is returned if the key does not exist.
+			/// @param key The key.
+			/// @return The value pointed to by the key.
+			const value_t *operator[](const key_t &key) const;
+		
+			/// @brief Returns the pointer to the value pointed to by the key. Null is returned if the key does not exist.
+			/// @param key The key.
+			/// @return The value pointed to by the key.
+			value_t *operator[](const key_t &key);
+
+			/// @brief Looks up several keys at once. Since the look-ups are interleaved, the memory accesses of one look-up overlap with those of the others, which makes this faster than looking up the keys one at a time.
+			/// @param keys The keys.
+			/// @param n The number of keys.
+			/// @param out Receives the pointer to the value pointed to by each key, or null if the key does not exist. Must have room for n pointers.
+			void lookup_batch(const key_t *keys, uint64_t n, const value_t **out) const;
+
+			/// @brief Looks up several keys at once. Since the look-ups are interleaved, the memory accesses of one look-up overlap with those of the others, which makes this faster than looking up the keys one at a time.
+			/// @param keys The keys.
+			/// @param n The number of keys.
+			/// @param out Receives the pointer to the value pointed to by each key, or null if the key does not exist. Must have room for n pointers.
+			void lookup_batch(const key_t *keys, uint64_t n, value_t **out);
+
+			/// @brief Returns a reference to the value pointed to by the key. If the value does not exist, there will be a null pointer dereference, and possibly a crash.
+			/// @param key The key.
+			/// @return The reference to the value pointed to by the key.
+			/// @warning May crash the application if the value does not exist. Only use this function if you are sure the value exists.
+			const value_t &operator()(const key_t &key) const;
+
+			/// @brief Returns a reference to the value pointed to by the key. If the value does not exist, a new value will be created making this function always safe to call (the value returned may, however, not be initialized).
+			/// @param key The key.
+			/// @return The reference to the value pointed to by the key.
+			value_t &operator()(const key_t &key);
+
+			/// @brief Returns a reference to the value pointed to by the key. If the value does not exist, a new value will be created making this function always safe to call (the value returned may, however, not be initialized).
+			/// @param key The key.
+			/// @return The reference to the value pointed to by the key.
+			value_t &insert(const key_t &key);
+
+			/// @brief Removes a value with the specified key. If the value does not exist nothing will happen.
+			/// @param key The key.
+			void remove(const key_t &key);
+
+			/// @brief Removes all values. Memory is kept for reuse, so that filling the dictionary up to its previous size again does not allocate.
+			/// @note Takes constant time when keys and values are trivially destructible.
+			void clear( void );
+
+			/// @brief Allocates room for a number of values, and the nodes needed to find them, so that inserting that many values does not reallocate memory. Values already in the dictionary are kept.
+			/// @param entries The number of values to make room for.
+			/// @param tables Optional. The number of nodes to make room for, if more than the one node per value that is always needed.
+			void reserve(uint64_t entries, uint64_t tables = 0);
+
+			/// @brief Rebuilds the dictionary into storage of exactly the size needed, dropping removed values and unused nodes. Nodes and values are renumbered breadth-first so that the upper levels of the tree sit together in memory.
+			/// @note Takes time and temporary memory proportional to the size of the dictionary. Pointers to values are invalidated.
+			void compact( void );
+
+			/// @brief Defragments storage a little at a time. Values and nodes in use at the end of storage are moved into the holes left by removed values and nodes, and storage that is no longer in use is freed. Calling this repeatedly converges towards the memory use of compact without a long pause.
+			/// @param budget The maximum number of values and nodes to move or release.
+			/// @return True if there may be more to defragment, false if storage is packed.
+			/// @note Pointers to values are invalidated. Storage grown with geometric_growth or linear_growth is only reallocated once at most half of it is in use, and only if its contents fit in what is left of the budget, since reallocating moves all of them. Larger storage is left for compact to release. Storage grown with segmented_growth is released without moving anything.
+			bool defrag_step(uint64_t budget);
+
+			/// @brief Returns the total space, in bytes, allocated by the data structure.
+			/// @return  The total space, in bytes, allocated by the data structure.
+			uint64_t allocated_bytes( void ) const;
+
+			/// @brief Returns the total space, in bytes, used by the data structure.
+			/// @return The total space, in bytes, used by the data structure.
+			uint64_t used_bytes( void ) const;
+
+			/// @brief Returns the number of values stored in the data structure.
+			/// @return The number of values stored in the data structure.
+			uint64_t size( void ) const;
+
+			/// @brief Calls a function once for each key-value pair in the dictionary. Values are visited in the order they are stored in memory rather than in key order.
+			/// @tparam func_t The type of the function, called as f(const key_t &key, value_t &value).
+			/// @param f The function.
+			/// @warning The dictionary must not be modified by the function, other than through the value passed to it.
+			template < typename func_t >
+			void for_each(func_t &&f);
+
+			/// @brief Calls a function once for each key-value pair in the dictionary. Values are visited in the order they are stored in memory rather than in key order.
+			/// @tparam func_t The type of the function, called as f(const key_t &key, const value_t &value).
+			/// @param f The function.
+			template < typename func_t >
+			void for_each(func_t &&f) const;
+
+			/// @brief Counts the number of look-ups made to find the requested value at the key.
+			/// @param key The key.
+			/// @param tables Optional. Receives the number of nodes visited to find the value.
+			/// @return The position of the last key byte examined to find the value at the key plus one.
+			uint64_t prof_lookup(const key_t &key, uint64_t *tables = nullptr) const;
+
+			/// @brief Returns the number of nodes currently allocated for the dictionary.
+			/// @return The number of nodes currently allocated for the dictionary.
+			uint64_t table_count( void ) const;
+
+			/// @brief Returns the number of nodes allocated for a number of keys. Always exact, since a crit-bit tree of n values has n - 1 nodes.
+			/// @param entries The number of keys.
+			/// @return The number of nodes.
+			static uint64_t estimate_tables(uint64_t entries);
+		};
+
+		/// @brief A dictionary engine that stores the positions of values in an open-addressing hash table. Slots are probed in groups of 16, with one control byte per slot holding 7 bits of the hash of the key, so that most mismatching slots are skipped without reading their keys.
+		/// @tparam key_t The type of the key.
+		/// @tparam value_t The type of the value.
+		/// @tparam policy_t The policies used to configure the dictionary. See dict_policy.
+		template < typename key_t, typename value_t, typename policy_t >
+		class flat
+		{
+		private:
+			template < typename type_t >
+			using array = cc0::internal::array<type_t, typename policy_t::growth, typename policy_t::allocator>;
+
+			typedef typename policy_t::index::word_t word_t;
+
+			static const uint64_t NUM_SLOTS_IN_GROUP = 16;
+			static const uint64_t NUM_BATCH_LOOKUPS  = 16;
+
+			/// @brief The states of a slot stored in its control byte. A slot in use stores the lower 7 bits of the hash of its key instead.
+			enum : uint8_t {
+				EMPTY   = 0x80, // The slot has never been used. Probing stops at a group with an empty slot.
+				DELETED = 0xFE  // The slot has been used, but the value was removed. Probing continues past it.
+			};
+
+			/// @brief A group of slots. The control bytes of a group fit in a single SIMD register.
+			struct group
+			{
+				uint8_t ctrl[NUM_SLOTS_IN_GROUP]; // The control bytes of the slots.
+				word_t  idx[NUM_SLOTS_IN_GROUP];  // The positions of the values in the value array.
+			};
+
+		private:
+			typename policy_t::layout::template type<key_t, value_t, policy_t> m_vals;
+			array<group>                                                       m_groups;
+			uint64_t                                                           m_used; // The number of slots that are in use or deleted.
+
+		private:
+			static uint32_t       match(const group &g, uint8_t c);
+			static uint32_t       match_free(const group &g);
+			static uint64_t       lowest(uint32_t mask);
+			uint64_t              mask( void ) const;
+			bool                  find(const key_t &k, uint64_t h, uint64_t &g, uint64_t &s) const;
+			uint64_t              probes(const key_t &k) const;
+			void                  place(array<group> &groups, uint64_t h, uint64_t e);
+			void                  rehash(uint64_t num_groups);
+			const value_t        *lookup(const key_t &k) const;
+			value_t              &lookup_or_alloc(const key_t &k);
+
+		public:
+			/// @brief Initializes the data structure. No memory is allocated until the first value is inserted.
+			flat( void );
+
+			/// @brief Copies a dictionary.
+			/// @param d The dictionary to copy.
+			flat(const flat &d);
+
+			/// @brief Moves data from one dictionary to another.
+			/// @param d The dictionary to move data from.
+			flat(flat &&d) noexcept;
+
+			/// @brief Copies a dictionary.
+			/// @param d The dictionary to copy.
+			/// @return A reference to self.
+			flat &operator=(const flat &d);
+
+			/// @brief Moves data from one dictionary to another.
+			/// @param d The dictionary to move data from.
+			/// @return A reference to self.
+			flat &operator=(flat &&d) noexcept;
+
+			/// @brief Returns the pointer to the value pointed to by the key. Null is returned if the key does not exist.
+			/// @param key The key.
+			/// @return The value pointed to by the key.
+			const value_t *operator[](const key_t &key) const;
+		
+			/// @brief Returns the pointer to the value pointed to by the key. Null is returned if the key does not exist.
+			/// @param key The key.
+			/// @return The value pointed to by the key.
+			value_t *operator[](const key_t &key);
+
+			/// @brief Looks up several keys at once. Since the look-ups are interleaved, the memory accesses of one look-up overlap with those of the others, which makes this faster than looking up the keys one at a time.
+			/// @param keys The keys.
+			/// @param n The number of keys.
+			/// @param out Receives the pointer to the value pointed to by each key, or null if the key does not exist. Must have room for n pointers.
+			void lookup_batch(const key_t *keys, uint64_t n, const value_t **out) const;
+
+			/// @brief Looks up several keys at once. Since the look-ups are interleaved, the memory accesses of one look-up overlap with those of the others, which makes this faster than looking up the keys one at a time.
+			/// @param keys The keys.
+			/// @param n The number of keys.
+			/// @param out Receives the pointer to the value pointed to by each key, or null if the key does not exist. Must have room for n pointers.
+			void lookup_batch(const key_t *keys, uint64_t n, value_t **out);
+
+			/// @brief Returns a reference to the value pointed to by the key. If the value does not exist, there will be a null pointer dereference, and possibly a crash.
+			/// @param key The key.
+			/// @return The reference to the value pointed to by the key.
+			/// @warning May crash the application if the value does not exist. Only use this function if you are sure the value exists.
+			const value_t &operator()(const key_t &key) const;
+
+			/// @brief Returns a reference to the value pointed to by the key. If the value does not exist, a new value will be created making this function always safe to call (the value returned may, however, not be initialized).
+			/// @param key The key.
+			/// @return The reference to the value pointed to by the key.
+			value_t &operator()(const key_t &key);
+
+			/// @brief Returns a reference to the value pointed to by the key. If the value does not exist, a new value will be created making this function always safe to call (the value returned may, however, not be initialized).
+			/// @param key The key.
+			/// @return The reference to the value pointed to by the key.
+			value_t &insert(const key_t &key);
+
+			/// @brief Removes a value with the specified key. If the value does not exist nothing will happen.
+			/// @param key The key.
+			void remove(const key_t &key);
+
+			/// @brief Removes all values. Memory is kept for reuse, so that filling the dictionary up to its previous size again does not allocate.
+			/// @note Takes constant time when keys and values are trivially destructible, apart from marking every slot of the hash table as empty.
+			void clear( void );
+
+			/// @brief Allocates room for a number of values, and grows the hash table so that inserting that many values does not rehash. Values already in the dictionary are kept.
+			/// @param entries The number of values to make room for.
+			/// @param tables Optional. The number of groups of slots to make room for, if more than needed for the values. Rounded up to a power of two.
+			void reserve(uint64_t entries, uint64_t tables = 0);
+
+			/// @brief Rebuilds the dictionary into storage of exactly the size needed, dropping removed values and deleted slots. The hash table is shrunk to the smallest size that holds the values, and values are renumbered in the order of their slots.
+			/// @note Takes time and temporary memory proportional to the size of the dictionary. Pointers to values are invalidated.
+			void compact( void );
+
+			/// @brief Defragments storage a little at a time. Values in use at the end of storage are moved into the holes left by removed values, and storage that is no longer in use is freed. Calling this repeatedly converges towards the memory use of compact without a long pause. The hash table itself is only shrunk by compact.
+			/// @param budget The maximum number of values to move or release.
+			/// @return True if there may be more to defragment, false if storage is packed.
+			/// @note Pointers to values are invalidated. Storage grown with geometric_growth or linear_growth is only reallocated once at most half of it is in use, and only if its contents fit in what is left of the budget, since reallocating moves all of them. Larger storage is left for compact to release. Storage grown with segmented_growth is released without moving anything.
+			bool defrag_step(uint64_t budget);
+
+			/// @brief Returns the total space, in bytes, allocated by the data structure.
+			/// @return  The total space, in bytes, allocated by the data structure.
+			uint64_t allocated_bytes( void ) const;
+
+			/// @brief Returns the total space, in bytes, used by the data structure.
+			/// @return The total space, in bytes, used by the data structure.
+			uint64_t used_bytes( void ) const;
+
+			/// @brief Returns the number of values stored in the data structure.
+			/// @return The number of values stored in the data structure.
+			uint64_t size( void ) const;
+
+			/// @brief Calls a function once for each key-value pair in the dictionary. Values are visited in the order they are stored in memory rather than in key order.
+			/// @tparam func_t The type of the function, called as f(const key_t &key, value_t &value).
+			/// @param f The function.
+			/// @warning The dictionary must not be modified by the function, other than through the value passed to it.
+			template < typename func_t >
+			void for_each(func_t &&f);
+
+			/// @brief Calls a function once for each key-value pair in the dictionary. Values are visited in the order they are stored in memory rather than in key order.
+			/// @tparam func_t The type of the function, called as f(const key_t &key, const value_t &value).
+			/// @param f The function.
+			template < typename func_t >
+			void for_each(func_t &&f) const;
+
+			/// @brief Counts the number of look-ups made to find the requested value at the key.
+			/// @param key The key.
+			/// @param tables Optional. Receives the number of groups of slots probed to find the value.
+			/// @return The number of key bytes examined, which is always the size of the key since the whole key is hashed.
+			uint64_t prof_lookup(const key_t &key, uint64_t *tables = nullptr) const;
+
+			/// @brief Returns the number of groups of slots currently allocated for the dictionary.
+			/// @return The number of groups of slots currently allocated for the dictionary.
+			uint64_t table_count( void ) const;
+
+			/// @brief Returns the number of groups of slots allocated for a number of keys.
+			/// @param entries The number of keys.
+			/// @return The number of groups of slots.
+			static uint64_t estimate_tables(uint64_t entries);
+		};
+	}
+
+	/// @brief A dictionary/hash table/map type where an arbitary key type can be used as an index to find a particular value stored in the data structure.
+	/// @tparam key_t The type of the key used to access values. Default behavior is to compare keys using a bytewise comparison.
+	/// @tparam value_t The type of the value to be stored in the table.
+	/// @tparam policy_t The policies used to configure the dictionary. See dict_policy.
+	/// @note This means that keys containing pointers to data most likely will fail equality tests even though the data being pointed to is the same between two keys if they merely are copies. A common issue would be to use std::string as a key (use const char* as a key since constant strings are stored globally in the binary in C and C++). For the general purpose use a custom digest class as a key instead, or provide your own custom comparison function.
+	/// @note Due to how this table is implemented, look up is O(n) in time complexity, where n is the number of bytes in the key type. However, for many cases, using a good key will result in a hit in just a few iterations. 
+	/// @note The interface of the dictionary is provided by the engine selected by the policy. See trie_engine, critbit_engine, and flat_engine.
+	/// @note The number of values a dictionary can hold is limited by the width of its indices. The default, index64, allows fewer than 2^46 values. index32 halves the size of tables, but allows fewer than 2^30 values. Exceeding the limit aborts the program with a message.
+	template < typename key_t, typename value_t, typename policy_t = cc0::dict_policy >
+	class dict : public policy_t::engine::template type<key_t, value_t, policy_t>
+	{};
+}
+
+//
+// has_position
+//
+
+constexpr bool cc0::internal::has_position(uint8_t)
+{
+	return false;
+}
+
+template < typename... rest_t >
+constexpr bool cc0::internal::has_position(uint8_t p, uint8_t first, rest_t... rest)
+{
+	return p == first || has_position(p, rest...);
+}
+
+//
+// is_permutation
+//
+
+constexpr bool cc0::internal::is_permutation(uint64_t)
+{
+	return true;
+}
+
+template < typename... rest_t >
+constexpr bool cc0::internal::is_permutation(uint64_t size, uint8_t first, rest_t... rest)
+{
+	// NOTE: C++11 constexpr functions consist of a single return statement, so the list is walked by recursion.
+	return first < size && !has_position(first, rest...) && is_permutation(size, rest...);
+}
+
+//
+// fatal
+//
+
+inline void cc0::internal::fatal(const char *msg)
+{
+	std::fputs(msg, stderr);
+	std::fputs("\n", stderr);
+	std::abort();
+}
+
+//
+// fnv1a64
+//
+template < typename type_t >
+cc0::internal::fnv1a64::fnv1a64(const type_t &in) : fnv1a64(&in, sizeof(in))
+{}
+
+template < typename type_t >
+cc0::internal::fnv1a64 &cc0::internal::fnv1a64::operator()(const type_t &in)
+{
+	ingest(&in, sizeof(in));
+	return *this;
+}
+
+template < typename type_t >
+cc0::internal::fnv1a64 cc0::internal::fnv1a64::operator()(const type_t &in) const
+{
+	return fnv1a64(*this)(in);
+}
+
+//
+// hash
+//
+
+template < typename key_t >
+uint64_t cc0::internal::hash(const key_t &k)
+{
+	// NOTE: Keys are mixed eight bytes at a time, and the result is finalized so that all bits of the hash depend on all bits of the key. Both the lower and upper bits of the hash are used. Whole words are assembled in a single expression, which compilers turn into a single load.
+	const uint8_t *b = reinterpret_cast<const uint8_t*>(&k);
+	uint64_t h = 0x9e3779b97f4a7c15ULL ^ sizeof(key_t);
+	uint64_t i = 0;
+	for (; i + 8 <= sizeof(key_t); i += 8) {
+		const uint64_t w =
+			uint64_t(b[i])             | (uint64_t(b[i + 1]) << 8)  | (uint64_t(b[i + 2]) << 16) | (uint64_t(b[i + 3]) << 24) |
+			(uint64_t(b[i + 4]) << 32) | (uint64_t(b[i + 5]) << 40) | (uint64_t(b[i + 6]) << 48) | (uint64_t(b[i + 7]) << 56);
+		h = (h ^ w) * 0xbf58476d1ce4e5b9ULL;
+		h ^= h >> 31;
+	}
+	if (i < sizeof(key_t)) {
+		uint64_t w = 0;
+		for (uint64_t j = 0; i + j < sizeof(key_t); ++j) {
+			w |= uint64_t(b[i + j]) << (j * 8);
+		}
+		h = (h ^ w) * 0xbf58476d1ce4e5b9ULL;
+		h ^= h >> 31;
+	}
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+//
+// key
+//
+
+template < typename type_t >
+cc0::key<type_t>::key(const type_t &v) : k(cc0::internal::fnv1a64(&v, sizeof(v)))
+{}
+
+//
+// geometric_growth
+//
+
+inline uint64_t cc0::geometric_growth::grow(uint64_t pool, uint64_t step)
+{
+	return pool + (pool > step ? pool : step);
+}
+
+//
+// linear_growth
+//
+
+inline uint64_t cc0::linear_growth::grow(uint64_t pool, uint64_t step)
+{
+	return pool + step;
+}
+
+//
+// heap_allocator
+//
+
+inline void *cc0::heap_allocator::allocate(uint64_t bytes, uint64_t align)
+{
+	if (align <= alignof(std::max_align_t)) {
+		return ::operator new(bytes);
+	}
+	// NOTE: The global heap only guarantees alignment up to max_align_t. Stricter alignments are handled by over-allocating, and storing the pointer to free just before the aligned memory.
+	uint8_t *p = reinterpret_cast<uint8_t*>(::operator new(bytes + align + sizeof(void*)));
+	uint8_t *aligned = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(p) + sizeof(void*) + align - 1) & ~uintptr_t(align - 1));
+	reinterpret_cast<void**>(aligned)[-1] = p;
+	return aligned;
+}
+
+inline void cc0::heap_allocator::deallocate(void *p, uint64_t, uint64_t align)
+{
+	if (align <= alignof(std::max_align_t)) {
+		::operator delete(p);
+	} else {
+		::operator delete(reinterpret_cast<void**>(p)[-1]);
+	}
+}
+
+//
+// bump_arena
+//
+
+inline cc0::bump_arena::block *cc0::bump_arena::new_block(uint64_t size)
+{
+	block *b = reinterpret_cast<block*>(::operator new(size));
+	b->next = nullptr;
+	b->size = size;
+	return b;
+}
+
+inline cc0::bump_arena::bump_arena(uint64_t block_size) : m_blocks(nullptr), m_at(nullptr), m_end(nullptr), m_block_size(block_size > sizeof(block) ? block_size : sizeof(block) * 2), m_allocated(0)
+{}
+
+inline cc0::bump_arena::~bump_arena( void )
+{
+	while (m_blocks != nullptr) {
+		block *next = m_blocks->next;
+		::operator delete(m_blocks);
+		m_blocks = next;
+	}
+}
+
+inline void *cc0::bump_arena::allocate(uint64_t bytes, uint64_t align)
+{
+	uint8_t *p = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(m_at) + align - 1) & ~uintptr_t(align - 1));
+	if (m_at != nullptr && p + bytes <= m_end) {
+		m_at = p + bytes;
+		return p;
+	}
+	const uint64_t size = sizeof(block) + bytes + align;
+	if (size > m_block_size / 4 && m_blocks != nullptr) {
+		// NOTE: Large allocations get a block of their own, which is linked in behind the current block so that the rest of the current block is still used.
+		block *b = new_block(size);
+		b->next = m_blocks->next;
+		m_blocks->next = b;
+		m_allocated += size;
+		return reinterpret_cast<void*>((reinterpret_cast<uintptr_t>(b + 1) + align - 1) & ~uintptr_t(align - 1));
+	}
+	block *b = new_block(size > m_block_size ? size : m_block_size);
+	b->next = m_blocks;
+	m_blocks = b;
+	m_allocated += b->size;
+	m_end = reinterpret_cast<uint8_t*>(b) + b->size;
+	p = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(b + 1) + align - 1) & ~uintptr_t(align - 1));
+	m_at = p + bytes;
+	return p;
+}
+
+inline void cc0::bump_arena::clear( void )
+{
+	block *keep = nullptr;
+	while (m_blocks != nullptr) {
+		block *next = m_blocks->next;
+		if (keep == nullptr && m_blocks->size == m_block_size) {
+			keep = m_blocks;
+			keep->next = nullptr;
+		} else {
+			::operator delete(m_blocks);
+		}
+		m_blocks = next;
+	}
+	m_blocks = keep;
+	if (keep != nullptr) {
+		m_at = reinterpret_cast<uint8_t*>(keep + 1);
+		m_end = reinterpret_cast<uint8_t*>(keep) + keep->size;
+		m_allocated = keep->size;
+	} else {
+		m_at = nullptr;
+		m_end = nullptr;
+		m_allocated = 0;
+	}
+}
+
+inline uint64_t cc0::bump_arena::allocated_bytes( void ) const
+{
+	return m_allocated;
+}
+
+//
+// arena_allocator
+//
+
+template < cc0::bump_arena &(*arena_t)( void ) >
+void *cc0::arena_allocator<arena_t>::allocate(uint64_t bytes, uint64_t align)
+{
+	return arena_t().allocate(bytes, align);
+}
+
+template < cc0::bump_arena &(*arena_t)( void ) >
+void cc0::arena_allocator<arena_t>::deallocate(void*, uint64_t, uint64_t)
+{}
+
+//
+// allocate_pool
+//
+
+template < typename type_t, typename alloc_t >
+type_t *cc0::internal::allocate_pool(uint64_t size)
+{
+	return reinterpret_cast<type_t*>(alloc_t::allocate(size * sizeof(type_t), alignof(type_t)));
+}
+
+//
+// free_pool
+//
+
+template < typename type_t, typename alloc_t >
+void cc0::internal::free_pool(type_t *vals, uint64_t size)
+{
+	if (vals != nullptr) {
+		alloc_t::deallocate(vals, size * sizeof(type_t), alignof(type_t));
+	}
+}
+
+//
+// array
+//
+
+template < typename type_t, typename growth_t, typename alloc_t >
+void cc0::internal::array<type_t, growth_t, alloc_t>::truncate(uint64_t size)
+{
+	for (uint64_t i = size; i < m_size; ++i) {
+		m_vals[i].~type_t();
+	}
+	if (size < m_size) {
+		m_size = size;
+	}
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+cc0::internal::array<type_t, growth_t, alloc_t>::array(uint64_t growth) : m_vals(nullptr), m_size(0), m_pool(0), m_growth(growth > 0 ? growth : 1)
+{}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+cc0::internal::array<type_t, growth_t, alloc_t>::array(const cc0::internal::array<type_t, growth_t, alloc_t> &a) : array(a.m_growth)
+{
+	resize_pool(a.m_pool);
+	for (; m_size < a.m_size; ++m_size) {
+		new (m_vals + m_size) type_t(a.m_vals[m_size]);
+	}
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+cc0::internal::array<type_t, growth_t, alloc_t>::array(cc0::internal::array<type_t, growth_t, alloc_t> &&a) noexcept : m_vals(a.m_vals), m_size(a.m_size), m_pool(a.m_pool), m_growth(a.m_growth)
+{
+	a.m_vals = nullptr;
+	a.m_size = 0;
+	a.m_pool = 0;
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+cc0::internal::array<type_t, growth_t, alloc_t>::~array( void )
+{
+	destroy();
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+cc0::internal::array<type_t, growth_t, alloc_t> &cc0::internal::array<type_t, growth_t, alloc_t>::operator=(const cc0::internal::array<type_t, growth_t, alloc_t> &a)
+{
+	if (&a != this) {
+		truncate(0);
+		resize_pool(a.m_pool);
+		for (; m_size < a.m_size; ++m_size) {
+			new (m_vals + m_size) type_t(a.m_vals[m_size]);
+		}
+	}
+	return *this;
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+cc0::internal::array<type_t, growth_t, alloc_t> &cc0::internal::array<type_t, growth_t, alloc_t>::operator=(cc0::internal::array<type_t, growth_t, alloc_t> &&a) noexcept
+{
+	if (&a != this) {
+		destroy();
+		m_vals = a.m_vals;
+		m_size = a.m_size;
+		m_pool = a.m_pool;
+		m_growth = a.m_growth;
+		a.m_vals = nullptr;
+		a.m_size = 0;
+		a.m_pool = 0;
+	}
+	return *this;
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+void cc0::internal::array<type_t, growth_t, alloc_t>::destroy( void )
+{
+	truncate(0);
+	free_pool<type_t, alloc_t>(m_vals, m_pool);
+	m_vals = nullptr;
+	m_pool = 0;
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+void cc0::internal::array<type_t, growth_t, alloc_t>::create(uint64_t size)
+{
+	reserve(size);
+	resize(size);
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+void cc0::internal::array<type_t, growth_t, alloc_t>::reserve(uint64_t size)
+{
+	truncate(0);
+	if (size > m_pool) {
+		destroy();
+		m_vals = allocate_pool<type_t, alloc_t>(size);
+		m_pool = size;
+	}
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+void cc0::internal::array<type_t, growth_t, alloc_t>::resize(uint64_t size)
+{
+	if (size > m_pool) {
+		resize_pool(size);
+	}
+	for (; m_size < size; ++m_size) {
+		new (m_vals + m_size) type_t;
+	}
+	truncate(size);
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+void cc0::internal::array<type_t, growth_t, alloc_t>::resize_pool(uint64_t size)
+{
+	if (size > m_pool) {
+		// NOTE: Elements are moved into the new pool, and only the elements in use are touched.
+		type_t *vals = allocate_pool<type_t, alloc_t>(size);
+		for (uint64_t i = 0; i < m_size; ++i) {
+			new (vals + i) type_t(static_cast<type_t&&>(m_vals[i]));
+			m_vals[i].~type_t();
+		}
+		free_pool<type_t, alloc_t>(m_vals, m_pool);
+		m_vals = vals;
+		m_pool = size;
+	}
+	truncate(size);
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+bool cc0::internal::array<type_t, growth_t, alloc_t>::shrink_pool(uint64_t &budget)
+{
+	// NOTE: The pool is only reallocated once at most half of it is in use, so that shrinking does not undo the growth of the pool. Reallocating moves every element, so a pool with more elements than the budget is left as it is.
+	if (m_pool == 0 || m_size > m_pool / 2 || m_size > budget) {
+		return false;
+	}
+	budget -= m_size;
+	type_t *vals = m_size > 0 ? allocate_pool<type_t, alloc_t>(m_size) : nullptr;
+	for (uint64_t i = 0; i < m_size; ++i) {
+		new (vals + i) type_t(static_cast<type_t&&>(m_vals[i]));
+		m_vals[i].~type_t();
+	}
+	free_pool<type_t, alloc_t>(m_vals, m_pool);
+	m_vals = vals;
+	m_pool = m_size;
+	return true;
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+type_t &cc0::internal::array<type_t, growth_t, alloc_t>::add( void )
+{
+	if (m_size >= m_pool) {
+		resize_pool(growth_t::grow(m_pool, m_growth));
+	}
+	return *new (m_vals + m_size++) type_t;
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+template < typename arg_t >
+type_t &cc0::internal::array<type_t, growth_t, alloc_t>::add(arg_t &&arg)
+{
+	if (m_size >= m_pool) {
+		resize_pool(growth_t::grow(m_pool, m_growth));
+	}
+	return *new (m_vals + m_size++) type_t(static_cast<arg_t&&>(arg));
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+uint64_t cc0::internal::array<type_t, growth_t, alloc_t>::size( void ) const
+{
+	return m_size;
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+uint64_t cc0::internal::array<type_t, growth_t, alloc_t>::pool_size( void ) const
+{
+	return m_pool;
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+type_t &cc0::internal::array<type_t, growth_t, alloc_t>::operator[](uint64_t i)
+{
+	return m_vals[i];
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+const type_t &cc0::internal::array<type_t, growth_t, alloc_t>::operator[](uint64_t i) const
+{
+	return m_vals[i];
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+type_t &cc0::internal::array<type_t, growth_t, alloc_t>::first( void )
+{
+	return m_vals[0];
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+const type_t &cc0::internal::array<type_t, growth_t, alloc_t>::first( void ) const
+{
+	return m_vals[0];
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+type_t &cc0::internal::array<type_t, growth_t, alloc_t>::last( void )
+{
+	return m_vals[m_size - 1];
+}
+
+template < typename type_t, typename growth_t, typename alloc_t >
+const type_t &cc0::internal::array<type_t, growth_t, alloc_t>::last( void ) const
+{
+	return m_vals[m_size - 1];
+}
+
+//
+// array<type_t, segmented_growth>
+//
+
+template < typename type_t, typename alloc_t >
+void cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::add_chunk( void )
+{
+	// NOTE: Only the directory is copied when it runs out of space. It holds one pointer per chunk, so this is cheap compared to copying the elements.
+	if (m_num_chunks >= m_dir_size) {
+		const uint64_t dir_size = m_dir_size > 0 ? m_dir_size * 2 : 4;
+		type_t **chunks = reinterpret_cast<type_t**>(alloc_t::allocate(dir_size * sizeof(type_t*), alignof(type_t*)));
+		for (uint64_t i = 0; i < m_num_chunks; ++i) {
+			chunks[i] = m_chunks[i];
+		}
+		if (m_chunks != nullptr) {
+			alloc_t::deallocate(m_chunks, m_dir_size * sizeof(type_t*), alignof(type_t*));
+		}
+		m_chunks = chunks;
+		m_dir_size = dir_size;
+	}
+	m_chunks[m_num_chunks++] = allocate_pool<type_t, alloc_t>(CHUNK_SIZE);
+}
+
+template < typename type_t, typename alloc_t >
+void cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::truncate(uint64_t size)
+{
+	for (uint64_t i = size; i < m_size; ++i) {
+		(*this)[i].~type_t();
+	}
+	if (size < m_size) {
+		m_size = size;
+	}
+}
+
+template < typename type_t, typename alloc_t >
+cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::array(uint64_t) : m_chunks(nullptr), m_num_chunks(0), m_dir_size(0), m_size(0)
+{}
+
+template < typename type_t, typename alloc_t >
+cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::array(const cc0::internal::array<type_t, cc0::segmented_growth, alloc_t> &a) : array()
+{
+	resize_pool(a.pool_size());
+	for (; m_size < a.m_size; ++m_size) {
+		new (&(*this)[m_size]) type_t(a[m_size]);
+	}
+}
+
+template < typename type_t, typename alloc_t >
+cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::array(cc0::internal::array<type_t, cc0::segmented_growth, alloc_t> &&a) noexcept : m_chunks(a.m_chunks), m_num_chunks(a.m_num_chunks), m_dir_size(a.m_dir_size), m_size(a.m_size)
+{
+	a.m_chunks = nullptr;
+	a.m_num_chunks = 0;
+	a.m_dir_size = 0;
+	a.m_size = 0;
+}
+
+template < typename type_t, typename alloc_t >
+cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::~array( void )
+{
+	destroy();
+}
+
+template < typename type_t, typename alloc_t >
+cc0::internal::array<type_t, cc0::segmented_growth, alloc_t> &cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::operator=(const cc0::internal::array<type_t, cc0::segmented_growth, alloc_t> &a)
+{
+	if (&a != this) {
+		truncate(0);
+		resize_pool(a.pool_size());
+		for (; m_size < a.m_size; ++m_size) {
+			new (&(*this)[m_size]) type_t(a[m_size]);
+		}
+	}
+	return *this;
+}
+
+template < typename type_t, typename alloc_t >
+cc0::internal::array<type_t, cc0::segmented_growth, alloc_t> &cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::operator=(cc0::internal::array<type_t, cc0::segmented_growth, alloc_t> &&a) noexcept
+{
+	if (&a != this) {
+		destroy();
+		m_chunks = a.m_chunks;
+		m_num_chunks = a.m_num_chunks;
+		m_dir_size = a.m_dir_size;
+		m_size = a.m_size;
+		a.m_chunks = nullptr;
+		a.m_num_chunks = 0;
+		a.m_dir_size = 0;
+		a.m_size = 0;
+	}
+	return *this;
+}
+
+template < typename type_t, typename alloc_t >
+void cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::destroy( void )
+{
+	truncate(0);
+	for (uint64_t i = 0; i < m_num_chunks; ++i) {
+		free_pool<type_t, alloc_t>(m_chunks[i], CHUNK_SIZE);
+	}
+	if (m_chunks != nullptr) {
+		alloc_t::deallocate(m_chunks, m_dir_size * sizeof(type_t*), alignof(type_t*));
+	}
+	m_chunks = nullptr;
+	m_num_chunks = 0;
+	m_dir_size = 0;
+}
+
+template < typename type_t, typename alloc_t >
+void cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::create(uint64_t size)
+{
+	reserve(size);
+	resize(size);
+}
+
+template < typename type_t, typename alloc_t >
+void cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::reserve(uint64_t size)
+{
+	truncate(0);
+	while (pool_size() < size) {
+		add_chunk();
+	}
+}
+
+template < typename type_t, typename alloc_t >
+void cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::resize(uint64_t size)
+{
+	while (pool_size() < size) {
+		add_chunk();
+	}
+	for (; m_size < size; ++m_size) {
+		new (&(*this)[m_size]) type_t;
+	}
+	truncate(size);
+}
+
+template < typename type_t, typename alloc_t >
+void cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::resize_pool(uint64_t size)
+{
+	while (pool_size() < size) {
+		add_chunk();
+	}
+	truncate(size);
+}
+
+template < typename type_t, typename alloc_t >
+bool cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::shrink_pool(uint64_t&)
+{
+	// NOTE: Chunks are freed without moving elements, so the budget is not used.
+	const uint64_t num_chunks = (m_size + CHUNK_MASK) >> CHUNK_SHIFT;
+	if (num_chunks >= m_num_chunks) {
+		return false;
+	}
+	while (m_num_chunks > num_chunks) {
+		free_pool<type_t, alloc_t>(m_chunks[--m_num_chunks], CHUNK_SIZE);
+	}
+	return true;
+}
+
+template < typename type_t, typename alloc_t >
+type_t &cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::add( void )
+{
+	if (m_size >= pool_size()) {
+		add_chunk();
+	}
+	const uint64_t i = m_size++;
+	return *new (&m_chunks[i >> CHUNK_SHIFT][i & CHUNK_MASK]) type_t;
+}
+
+template < typename type_t, typename alloc_t >
+template < typename arg_t >
+type_t &cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::add(arg_t &&arg)
+{
+	if (m_size >= pool_size()) {
+		add_chunk();
+	}
+	const uint64_t i = m_size++;
+	return *new (&m_chunks[i >> CHUNK_SHIFT][i & CHUNK_MASK]) type_t(static_cast<arg_t&&>(arg));
+}
+
+template < typename type_t, typename alloc_t >
+uint64_t cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::size( void ) const
+{
+	return m_size;
+}
+
+template < typename type_t, typename alloc_t >
+uint64_t cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::pool_size( void ) const
+{
+	return m_num_chunks << CHUNK_SHIFT;
+}
+
+template < typename type_t, typename alloc_t >
+type_t &cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::operator[](uint64_t i)
+{
+	return m_chunks[i >> CHUNK_SHIFT][i & CHUNK_MASK];
+}
+
+template < typename type_t, typename alloc_t >
+const type_t &cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::operator[](uint64_t i) const
+{
+	return m_chunks[i >> CHUNK_SHIFT][i & CHUNK_MASK];
+}
+
+template < typename type_t, typename alloc_t >
+type_t &cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::first( void )
+{
+	return m_chunks[0][0];
+}
+
+template < typename type_t, typename alloc_t >
+const type_t &cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::first( void ) const
+{
+	return m_chunks[0][0];
+}
+
+template < typename type_t, typename alloc_t >
+type_t &cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::last( void )
+{
+	return (*this)[m_size - 1];
+}
+
+template < typename type_t, typename alloc_t >
+const type_t &cc0::internal::array<type_t, cc0::segmented_growth, alloc_t>::last( void ) const
+{
+	return (*this)[m_size - 1];
+}
+
+//
+// store::entry
+//
+
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::store<key_t, value_t, policy_t>::entry::entry(const key_t &key) : refs(1), next(0)
+{
+	new (&kv.k) key_t(key);
+	new (&kv.v) value_t;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::store<key_t, value_t, policy_t>::entry::entry(const entry &e) : refs(e.refs), next(e.next)
+{
+	if (refs != 0) {
+		new (&kv.k) key_t(e.kv.k);
+		new (&kv.v) value_t(e.kv.v);
+	} else {
+		prev = e.prev;
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::store<key_t, value_t, policy_t>::entry::entry(entry &&e) : refs(e.refs), next(e.next)
+{
+	if (refs != 0) {
+		new (&kv.k) key_t(static_cast<key_t&&>(e.kv.k));
+		new (&kv.v) value_t(static_cast<value_t&&>(e.kv.v));
+	} else {
+		prev = e.prev;
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::store<key_t, value_t, policy_t>::entry::~entry( void )
+{
+	if (refs != 0) {
+		kv.k.~key_t();
+		kv.v.~value_t();
+	}
+}
+
+//
+// store
+//
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::store<key_t, value_t, policy_t>::link(uint64_t e)
+{
+	entry &x = m_entries[e];
+	x.refs = 0;
+	x.prev = 0;
+	x.next = m_free;
+	if (m_free > 0) {
+		m_entries[m_free - 1].prev = e + 1;
+	}
+	m_free = e + 1;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::store<key_t, value_t, policy_t>::unlink(uint64_t e)
+{
+	const entry &x = m_entries[e];
+	if (x.prev > 0) {
+		m_entries[x.prev - 1].next = x.next;
+	} else {
+		m_free = x.next;
+	}
+	if (x.next > 0) {
+		m_entries[x.next - 1].prev = x.prev;
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::store<key_t, value_t, policy_t>::store( void ) : m_entries(16), m_free(0), m_size(0)
+{}
+
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::store<key_t, value_t, policy_t>::store(cc0::internal::store<key_t, value_t, policy_t> &&s) noexcept : m_entries(static_cast<array<entry, typename policy_t::growth, typename policy_t::allocator>&&>(s.m_entries)), m_free(s.m_free), m_size(s.m_size)
+{
+	s.m_free = 0;
+	s.m_size = 0;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::store<key_t, value_t, policy_t> &cc0::internal::store<key_t, value_t, policy_t>::operator=(cc0::internal::store<key_t, value_t, policy_t> &&s) noexcept
+{
+	if (&s != this) {
+		m_entries = static_cast<array<entry, typename policy_t::growth, typename policy_t::allocator>&&>(s.m_entries);
+		m_free = s.m_free;
+		m_size = s.m_size;
+		s.m_free = 0;
+		s.m_size = 0;
+	}
+	return *this;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::store<key_t, value_t, policy_t>::add(const key_t &k)
+{
+	uint64_t e = m_free;
+	if (e > 0) {
+		--e;
+		unlink(e);
+		entry &x = m_entries[e];
+		new (&x.kv.k) key_t(k);
+		new (&x.kv.v) value_t;
+		x.refs = 1;
+	} else {
+		e = m_entries.size();
+		m_entries.add(k);
+	}
+	++m_size;
+	return e;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::store<key_t, value_t, policy_t>::remove(uint64_t e)
+{
+	entry &x = m_entries[e];
+	x.kv.k.~key_t();
+	x.kv.v.~value_t();
+	link(e);
+	--m_size;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::store<key_t, value_t, policy_t>::clear( void )
+{
+	m_entries.truncate(0);
+	m_free = 0;
+	m_size = 0;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+bool cc0::internal::store<key_t, value_t, policy_t>::pack(uint64_t &from, uint64_t &to, uint64_t &budget)
+{
+	const uint64_t end = m_entries.size();
+	if (end > 0 && m_entries[end - 1].refs == 0) {
+		// NOTE: A free entry at the end is released rather than filled. The free list is doubly linked, so it is unlinked without walking the list.
+		unlink(end - 1);
+		m_entries.truncate(end - 1);
+		from = to = end - 1;
+		return true;
+	}
+	if (m_free == 0) {
+		from = to = end;
+		return m_entries.shrink_pool(budget);
+	}
+	to = m_free - 1;
+	unlink(to);
+	from = end - 1;
+	return true;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::store<key_t, value_t, policy_t>::relocate(uint64_t from, uint64_t to)
+{
+	entry &x = m_entries[to];
+	entry &y = m_entries[from];
+	new (&x.kv.k) key_t(static_cast<key_t&&>(y.kv.k));
+	new (&x.kv.v) value_t(static_cast<value_t&&>(y.kv.v));
+	x.refs = 1;
+	m_entries.truncate(from);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+bool cc0::internal::store<key_t, value_t, policy_t>::cmp(uint64_t e, const key_t &k) const
+{
+	const uint8_t *A = reinterpret_cast<const uint8_t*>(&m_entries[e].kv.k);
+	const uint8_t *B = reinterpret_cast<const uint8_t*>(&k);
+	for (uint64_t i = 0; i < sizeof(key_t); ++i) {
+		if (A[i] != B[i]) { return false; }
+	}
+	return true;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+const key_t &cc0::internal::store<key_t, value_t, policy_t>::key(uint64_t e) const
+{
+	return m_entries[e].kv.k;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+value_t &cc0::internal::store<key_t, value_t, policy_t>::value(uint64_t e)
+{
+	return m_entries[e].kv.v;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+const value_t &cc0::internal::store<key_t, value_t, policy_t>::value(uint64_t e) const
+{
+	return m_entries[e].kv.v;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::store<key_t, value_t, policy_t>::prefetch(uint64_t e) const
+{
+	CC0_DICT_PREFETCH(&m_entries[e].kv.k);
+	CC0_DICT_PREFETCH(&m_entries[e].kv.v);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+template < typename func_t >
+void cc0::internal::store<key_t, value_t, policy_t>::for_each(func_t &f)
+{
+	for (uint64_t e = 0; e < m_entries.size(); ++e) {
+		entry &x = m_entries[e];
+		if (x.refs != 0) {
+			f(static_cast<const key_t&>(x.kv.k), x.kv.v);
+		}
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+template < typename func_t >
+void cc0::internal::store<key_t, value_t, policy_t>::for_each(func_t &f) const
+{
+	for (uint64_t e = 0; e < m_entries.size(); ++e) {
+		const entry &x = m_entries[e];
+		if (x.refs != 0) {
+			f(x.kv.k, x.kv.v);
+		}
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::store<key_t, value_t, policy_t>::size( void ) const
+{
+	return m_size;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::store<key_t, value_t, policy_t>::reserve(uint64_t entries)
+{
+	if (entries > m_entries.pool_size()) {
+		m_entries.resize_pool(entries);
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::store<key_t, value_t, policy_t>::allocated_bytes( void ) const
+{
+	return m_entries.pool_size() * sizeof(entry);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::store<key_t, value_t, policy_t>::used_bytes( void ) const
+{
+	return m_size * sizeof(entry);
+}
+
+//
+// column_store
+//
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::column_store<key_t, value_t, policy_t>::free_bits(uint64_t w) const
+{
+	// NOTE: Bits past the last entry are not entries, so they are masked out of the last word.
+	const uint64_t n = m_keys.size() - (w << 6);
+	return n < 64 ? ~m_live[w] & ((uint64_t(1) << n) - 1) : ~m_live[w];
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::column_store<key_t, value_t, policy_t>::link(uint64_t w)
+{
+	if (m_slot[w] == 0) {
+		m_free.add() = w;
+		m_slot[w] = m_free.size();
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::column_store<key_t, value_t, policy_t>::unlink(uint64_t w)
+{
+	// NOTE: The last word in the list takes the place of the unlinked word, so unlinking any word is O(1).
+	const uint64_t i = m_slot[w] - 1;
+	const uint64_t last = m_free.last();
+	m_free[i] = last;
+	m_slot[last] = i + 1;
+	m_free.resize(m_free.size() - 1);
+	m_slot[w] = 0;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::column_store<key_t, value_t, policy_t>::take( void )
+{
+	const uint64_t w = m_free.last();
+	const uint64_t e = (w << 6) + lowest(free_bits(w));
+	m_live[w] |= uint64_t(1) << (e & 63);
+	if (free_bits(w) == 0) {
+		unlink(w);
+	}
+	return e;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::column_store<key_t, value_t, policy_t>::lowest(uint64_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return uint64_t(__builtin_ctzll(mask));
+#else
+	uint64_t i = 0;
+	while ((mask & 1) == 0) {
+		mask >>= 1;
+		++i;
+	}
+	return i;
+#endif
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::column_store<key_t, value_t, policy_t>::column_store( void ) : m_keys(16), m_values(16), m_live(1), m_free(1), m_slot(1), m_size(0)
+{}
+
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::column_store<key_t, value_t, policy_t>::column_store(cc0::internal::column_store<key_t, value_t, policy_t> &&s) noexcept : m_keys(static_cast<array<key_t, typename policy_t::growth, typename policy_t::allocator>&&>(s.m_keys)), m_values(static_cast<array<value_t, typename policy_t::growth, typename policy_t::allocator>&&>(s.m_values)), m_live(static_cast<array<uint64_t, typename policy_t::growth, typename policy_t::allocator>&&>(s.m_live)), m_free(static_cast<array<uint64_t, typename policy_t::growth, typename policy_t::allocator>&&>(s.m_free)), m_slot(static_cast<array<uint64_t, typename policy_t::growth, typename policy_t::allocator>&&>(s.m_slot)), m_size(s.m_size)
+{
+	s.m_size = 0;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::column_store<key_t, value_t, policy_t> &cc0::internal::column_store<key_t, value_t, policy_t>::operator=(cc0::internal::column_store<key_t, value_t, policy_t> &&s) noexcept
+{
+	if (&s != this) {
+		m_keys = static_cast<array<key_t, typename policy_t::growth, typename policy_t::allocator>&&>(s.m_keys);
+		m_values = static_cast<array<value_t, typename policy_t::growth, typename policy_t::allocator>&&>(s.m_values);
+		m_live = static_cast<array<uint64_t, typename policy_t::growth, typename policy_t::allocator>&&>(s.m_live);
+		m_free = static_cast<array<uint64_t, typename policy_t::growth, typename policy_t::allocator>&&>(s.m_free);
+		m_slot = static_cast<array<uint64_t, typename policy_t::growth, typename policy_t::allocator>&&>(s.m_slot);
+		m_size = s.m_size;
+		s.m_size = 0;
+	}
+	return *this;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::column_store<key_t, value_t, policy_t>::add(const key_t &k)
+{
+	uint64_t e;
+	if (m_free.size() > 0) {
+		e = take();
+		m_keys[e] = k;
+	} else {
+		e = m_keys.size();
+		m_keys.add(k);
+		m_values.add();
+		if ((e & 63) == 0) {
+			m_live.add() = 0;
+			m_slot.add() = 0;
+		}
+		m_live[e >> 6] |= uint64_t(1) << (e & 63);
+	}
+	++m_size;
+	return e;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::column_store<key_t, value_t, policy_t>::remove(uint64_t e)
+{
+	// NOTE: Columns have no holes, so the value is replaced by a new value rather than left destroyed. This still releases whatever the removed value held on to.
+	m_values[e].~value_t();
+	new (&m_values[e]) value_t;
+	m_live[e >> 6] &= ~(uint64_t(1) << (e & 63));
+	link(e >> 6);
+	--m_size;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::column_store<key_t, value_t, policy_t>::clear( void )
+{
+	m_keys.truncate(0);
+	m_values.truncate(0);
+	m_live.truncate(0);
+	m_free.truncate(0);
+	m_slot.truncate(0);
+	m_size = 0;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+bool cc0::internal::column_store<key_t, value_t, policy_t>::pack(uint64_t &from, uint64_t &to, uint64_t &budget)
+{
+	const uint64_t end = m_keys.size();
+	if (end > 0 && (m_live[(end - 1) >> 6] & (uint64_t(1) << ((end - 1) & 63))) == 0) {
+		// NOTE: A free entry at the end is released rather than filled. Its word leaves the free list once it has no other free entries.
+		const uint64_t w = (end - 1) >> 6;
+		m_keys.truncate(end - 1);
+		m_values.truncate(end - 1);
+		if (free_bits(w) == 0) {
+			unlink(w);
+		}
+		if (((end - 1) & 63) == 0) {
+			m_live.truncate(w);
+			m_slot.truncate(w);
+		}
+		from = to = end - 1;
+		return true;
+	}
+	if (m_free.size() == 0) {
+		from = to = end;
+		bool shrunk = m_keys.shrink_pool(budget);
+		shrunk = m_values.shrink_pool(budget) || shrunk;
+		shrunk = m_live.shrink_pool(budget) || shrunk;
+		shrunk = m_free.shrink_pool(budget) || shrunk;
+		shrunk = m_slot.shrink_pool(budget) || shrunk;
+		return shrunk;
+	}
+	to = take();
+	from = end - 1;
+	return true;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::column_store<key_t, value_t, policy_t>::relocate(uint64_t from, uint64_t to)
+{
+	// NOTE: The entry moved to has already been marked as in use by pack.
+	m_keys[to] = m_keys[from];
+	m_values[to] = static_cast<value_t&&>(m_values[from]);
+	m_keys.truncate(from);
+	m_values.truncate(from);
+	if ((from & 63) == 0) {
+		m_live.truncate(from >> 6);
+		m_slot.truncate(from >> 6);
+	} else {
+		m_live[from >> 6] &= ~(uint64_t(1) << (from & 63));
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+bool cc0::internal::column_store<key_t, value_t, policy_t>::cmp(uint64_t e, const key_t &k) const
+{
+	const uint8_t *A = reinterpret_cast<const uint8_t*>(&m_keys[e]);
+	const uint8_t *B = reinterpret_cast<const uint8_t*>(&k);
+	for (uint64_t i = 0; i < sizeof(key_t); ++i) {
+		if (A[i] != B[i]) { return false; }
+	}
+	return true;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+const key_t &cc0::internal::column_store<key_t, value_t, policy_t>::key(uint64_t e) const
+{
+	return m_keys[e];
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+value_t &cc0::internal::column_store<key_t, value_t, policy_t>::value(uint64_t e)
+{
+	return m_values[e];
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+const value_t &cc0::internal::column_store<key_t, value_t, policy_t>::value(uint64_t e) const
+{
+	return m_values[e];
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::column_store<key_t, value_t, policy_t>::prefetch(uint64_t e) const
+{
+	// NOTE: Only the key is fetched, since the value is not needed unless the key matches.
+	CC0_DICT_PREFETCH(&m_keys[e]);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+template < typename func_t >
+void cc0::internal::column_store<key_t, value_t, policy_t>::for_each(func_t &f)
+{
+	// NOTE: Words of the liveness column with no entries in use are skipped as a whole.
+	for (uint64_t w = 0; w < m_live.size(); ++w) {
+		uint64_t live = m_live[w];
+		for (uint64_t e = w << 6; live != 0; ++e, live >>= 1) {
+			if ((live & 1) != 0) {
+				f(static_cast<const key_t&>(m_keys[e]), m_values[e]);
+			}
+		}
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+template < typename func_t >
+void cc0::internal::column_store<key_t, value_t, policy_t>::for_each(func_t &f) const
+{
+	for (uint64_t w = 0; w < m_live.size(); ++w) {
+		uint64_t live = m_live[w];
+		for (uint64_t e = w << 6; live != 0; ++e, live >>= 1) {
+			if ((live & 1) != 0) {
+				f(m_keys[e], m_values[e]);
+			}
+		}
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::column_store<key_t, value_t, policy_t>::size( void ) const
+{
+	return m_size;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::column_store<key_t, value_t, policy_t>::reserve(uint64_t entries)
+{
+	if (entries > m_keys.pool_size()) {
+		m_keys.resize_pool(entries);
+		m_values.resize_pool(entries);
+	}
+	if ((entries + 63) / 64 > m_live.pool_size()) {
+		m_live.resize_pool((entries + 63) / 64);
+		m_slot.resize_pool((entries + 63) / 64);
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::column_store<key_t, value_t, policy_t>::allocated_bytes( void ) const
+{
+	return
+		m_keys.pool_size() * sizeof(key_t) +
+		m_values.pool_size() * sizeof(value_t) +
+		m_live.pool_size() * sizeof(uint64_t) +
+		m_free.pool_size() * sizeof(uint64_t) +
+		m_slot.pool_size() * sizeof(uint64_t);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::column_store<key_t, value_t, policy_t>::used_bytes( void ) const
+{
+	return m_size * (sizeof(key_t) + sizeof(value_t)) + (m_live.size() + m_slot.size()) * sizeof(uint64_t);
+}
+
+//
+// memory_order
+//
+
+template < typename key_t >
+cc0::memory_order::path<key_t>::path( void ) : m_bytes(nullptr)
+{}
+
+template < typename key_t >
+cc0::memory_order::path<key_t>::path(const key_t &k) : m_bytes(reinterpret_cast<const uint8_t*>(&k))
+{}
+
+template < typename key_t >
+inline uint8_t cc0::memory_order::path<key_t>::operator[](uint64_t level) const
+{
+	return m_bytes[level];
+}
+
+//
+// reverse_order
+//
+
+template < typename key_t >
+cc0::reverse_order::path<key_t>::path( void ) : m_bytes(nullptr)
+{}
+
+template < typename key_t >
+cc0::reverse_order::path<key_t>::path(const key_t &k) : m_bytes(reinterpret_cast<const uint8_t*>(&k))
+{}
+
+template < typename key_t >
+inline uint8_t cc0::reverse_order::path<key_t>::operator[](uint64_t level) const
+{
+	return m_bytes[DEPTH - 1 - level];
+}
+
+//
+// msb_first_order
+//
+
+template < typename key_t >
+cc0::msb_first_order::path<key_t>::path( void ) : m_bytes(nullptr)
+{}
+
+template < typename key_t >
+cc0::msb_first_order::path<key_t>::path(const key_t &k) : m_bytes(reinterpret_cast<const uint8_t*>(&k))
+{}
+
+template < typename key_t >
+inline uint8_t cc0::msb_first_order::path<key_t>::operator[](uint64_t level) const
+{
+	return m_bytes[CC0_DICT_BIG_ENDIAN ? level : DEPTH - 1 - level];
+}
+
+//
+// permuted_order
+//
+
+template < uint8_t... positions >
+template < typename key_t >
+const uint8_t cc0::permuted_order<positions...>::path<key_t>::POSITIONS[sizeof...(positions)] = { positions... };
+
+template < uint8_t... positions >
+template < typename key_t >
+cc0::permuted_order<positions...>::path<key_t>::path( void ) : m_bytes(nullptr)
+{}
+
+template < uint8_t... positions >
+template < typename key_t >
+cc0::permuted_order<positions...>::path<key_t>::path(const key_t &k) : m_bytes(reinterpret_cast<const uint8_t*>(&k))
+{}
+
+template < uint8_t... positions >
+template < typename key_t >
+inline uint8_t cc0::permuted_order<positions...>::path<key_t>::operator[](uint64_t level) const
+{
+	return m_bytes[POSITIONS[level]];
+}
+
+//
+// hashed_order
+//
+
+template < typename key_t >
+cc0::hashed_order::path<key_t>::path( void ) : m_hash(0), m_bytes(nullptr)
+{}
+
+template < typename key_t >
+cc0::hashed_order::path<key_t>::path(const key_t &k) : m_hash(cc0::internal::hash(k)), m_bytes(reinterpret_cast<const uint8_t*>(&k))
+{}
+
+template < typename key_t >
+inline uint8_t cc0::hashed_order::path<key_t>::operator[](uint64_t level) const
+{
+	// NOTE: All bytes of the hash depend on all bytes of the key. The least significant bytes come first, since the trie takes its fingerprints from the most significant bits of the same hash. Keys that share a path then still tend to have distinct fingerprints.
+	return level < sizeof(uint64_t) ? uint8_t(m_hash >> (level * 8)) : m_bytes[level - sizeof(uint64_t)];
+}
+
+//
+// inline_entry
+//
+
+template < typename key_t, typename value_t, bool enabled_t >
+bool cc0::internal::inline_entry<key_t, value_t, enabled_t>::cmp(const key_t&) const
+{
+	return false;
+}
+
+template < typename key_t, typename value_t, bool enabled_t >
+void cc0::internal::inline_entry<key_t, value_t, enabled_t>::set(const key_t&)
+{}
+
+template < typename key_t, typename value_t, bool enabled_t >
+const key_t *cc0::internal::inline_entry<key_t, value_t, enabled_t>::key( void ) const
+{
+	return nullptr;
+}
+
+template < typename key_t, typename value_t, bool enabled_t >
+value_t *cc0::internal::inline_entry<key_t, value_t, enabled_t>::value( void )
+{
+	return nullptr;
+}
+
+template < typename key_t, typename value_t, bool enabled_t >
+const value_t *cc0::internal::inline_entry<key_t, value_t, enabled_t>::value( void ) const
+{
+	return nullptr;
+}
+
+template < typename key_t, typename value_t >
+cc0::internal::inline_entry<key_t, value_t, true>::inline_entry( void )
+{}
+
+template < typename key_t, typename value_t >
+bool cc0::internal::inline_entry<key_t, value_t, true>::cmp(const key_t &k) const
+{
+	const uint8_t *A = reinterpret_cast<const uint8_t*>(&this->k);
+	const uint8_t *B = reinterpret_cast<const uint8_t*>(&k);
+	for (uint64_t i = 0; i < sizeof(key_t); ++i) {
+		if (A[i] != B[i]) { return false; }
+	}
+	return true;
+}
+
+template < typename key_t, typename value_t >
+void cc0::internal::inline_entry<key_t, value_t, true>::set(const key_t &k)
+{
+	new (&this->k) key_t(k);
+	new (&v) value_t;
+}
+
+template < typename key_t, typename value_t >
+const key_t *cc0::internal::inline_entry<key_t, value_t, true>::key( void ) const
+{
+	return &k;
+}
+
+template < typename key_t, typename value_t >
+value_t *cc0::internal::inline_entry<key_t, value_t, true>::value( void )
+{
+	return &v;
+}
+
+template < typename key_t, typename value_t >
+const value_t *cc0::internal::inline_entry<key_t, value_t, true>::value( void ) const
+{
+	return &v;
+}
+
+//
+// index
+//
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::trie<key_t, value_t, policy_t>::index cc0::internal::trie<key_t, value_t, policy_t>::index::make(uint64_t type, uint64_t i, uint64_t fingerprint)
+{
+	index x;
+	x.w = word_t((i << 2) | type);
+	if (FINGERPRINT_BITS > 0) {
+		x.w |= word_t(fingerprint << ((WORD_BITS - FINGERPRINT_BITS) % WORD_BITS));
+	}
+	// NOTE: Fails if the dictionary holds more values or tables than the index policy has room for. See index32 and index64. Aborts rather than throws, since the caller has already started to modify the dictionary.
+	if (x.at() != i) {
+		cc0::internal::fatal("cc0::dict: too many values or tables for the index policy");
+	}
+	return x;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::trie<key_t, value_t, policy_t>::index::type( void ) const
+{
+	return uint64_t(w & 3);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::trie<key_t, value_t, policy_t>::index::at( void ) const
+{
+	return uint64_t(word_t(w << FINGERPRINT_BITS) >> (FINGERPRINT_BITS + 2));
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::trie<key_t, value_t, policy_t>::index::fingerprint( void ) const
+{
+	return FINGERPRINT_BITS > 0 ? uint64_t(w >> ((WORD_BITS - FINGERPRINT_BITS) % WORD_BITS)) : 0;
+}
+
+//
+// trie
+//
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::trie<key_t, value_t, policy_t>::index cc0::internal::trie<key_t, value_t, policy_t>::make_table(uint64_t size, uint64_t t)
+{
+	return index::make(index::TAB, (t << 2) | size);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::trie<key_t, value_t, policy_t>::table_size(index t)
+{
+	return t.at() & 3;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::trie<key_t, value_t, policy_t>::table_at(index t)
+{
+	return t.at() >> 2;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::trie<key_t, value_t, policy_t>::capacity(index t)
+{
+	switch (table_size(t)) {
+	case TAB4:  return 4;
+	case TAB16: return 16;
+	case TAB48: return 48;
+	}
+	return NUM_ENTRIES_IN_TABLE;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::init_table(table4 &t)
+{
+	t.h.refs = 0;
+	t.h.skip = 0;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::init_table(table16 &t)
+{
+	t.h.refs = 0;
+	t.h.skip = 0;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::init_table(table48 &t)
+{
+	t.h.refs = 0;
+	t.h.skip = 0;
+	for (uint64_t i = 0; i < NUM_ENTRIES_IN_TABLE; ++i) {
+		t.slot[i] = 0;
+	}
+	for (uint64_t i = 0; i < 48; ++i) {
+		t.idx[i] = index::make(index::NIL, 0);
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::init_table(table256 &t)
+{
+	t.h.refs = 0;
+	t.h.skip = 0;
+	for (uint64_t i = 0; i < NUM_ENTRIES_IN_TABLE; ++i) {
+		t.idx[i] = index::make(index::NIL, 0);
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::trie<key_t, value_t, policy_t>::head &cc0::internal::trie<key_t, value_t, policy_t>::get_head(index t)
+{
+	switch (table_size(t)) {
+	case TAB4:  return m_tab4[table_at(t)].h;
+	case TAB16: return m_tab16[table_at(t)].h;
+	case TAB48: return m_tab48[table_at(t)].h;
+	}
+	return m_tab256[table_at(t)].h;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+const typename cc0::internal::trie<key_t, value_t, policy_t>::head &cc0::internal::trie<key_t, value_t, policy_t>::get_head(index t) const
+{
+	switch (table_size(t)) {
+	case TAB4:  return m_tab4[table_at(t)].h;
+	case TAB16: return m_tab16[table_at(t)].h;
+	case TAB48: return m_tab48[table_at(t)].h;
+	}
+	return m_tab256[table_at(t)].h;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+template < typename table_t >
+typename cc0::internal::trie<key_t, value_t, policy_t>::index cc0::internal::trie<key_t, value_t, policy_t>::new_table(array<table_t> &tabs, uint64_t size)
+{
+	index t = m_free[size];
+	if (t.type() == index::TAB) {
+		unlink_table(tabs, t);
+	} else {
+		t = make_table(size, tabs.size());
+		tabs.add();
+	}
+	init_table(tabs[table_at(t)]);
+	return t;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::trie<key_t, value_t, policy_t>::index cc0::internal::trie<key_t, value_t, policy_t>::new_table(uint64_t size)
+{
+	switch (size) {
+	case TAB4:  return new_table(m_tab4, size);
+	case TAB16: return new_table(m_tab16, size);
+	case TAB48: return new_table(m_tab48, size);
+	}
+	return new_table(m_tab256, size);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+template < typename table_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::free_table(array<table_t> &tabs, index t)
+{
+	table_t &x = tabs[table_at(t)];
+	index &head = m_free[table_size(t)];
+	x.h.refs = 0;
+	x.idx[0] = head;
+	x.idx[1] = index::make(index::NIL, 0);
+	if (head.type() == index::TAB) {
+		tabs[table_at(head)].idx[1] = t;
+	}
+	head = t;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+template < typename table_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::unlink_table(array<table_t> &tabs, index t)
+{
+	const table_t &x = tabs[table_at(t)];
+	if (x.idx[1].type() == index::TAB) {
+		tabs[table_at(x.idx[1])].idx[0] = x.idx[0];
+	} else {
+		m_free[table_size(t)] = x.idx[0];
+	}
+	if (x.idx[0].type() == index::TAB) {
+		tabs[table_at(x.idx[0])].idx[1] = x.idx[1];
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::free_table(index t)
+{
+	switch (table_size(t)) {
+	case TAB4:   free_table(m_tab4, t);   break;
+	case TAB16:  free_table(m_tab16, t);  break;
+	case TAB48:  free_table(m_tab48, t);  break;
+	case TAB256: free_table(m_tab256, t); break;
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::trie<key_t, value_t, policy_t>::gather(index t, uint8_t *keys, index *idx) const
+{
+	uint64_t count = 0;
+	switch (table_size(t)) {
+	case TAB4:
+		{
+			const table4 &x = m_tab4[table_at(t)];
+			for (; count < x.h.refs; ++count) {
+				keys[count] = x.key[count];
+				idx[count] = x.idx[count];
+			}
+		}
+		break;
+	case TAB16:
+		{
+			const table16 &x = m_tab16[table_at(t)];
+			for (; count < x.h.refs; ++count) {
+				keys[count] = x.key[count];
+				idx[count] = x.idx[count];
+			}
+		}
+		break;
+	case TAB48:
+		{
+			const table48 &x = m_tab48[table_at(t)];
+			for (uint64_t b = 0; b < NUM_ENTRIES_IN_TABLE; ++b) {
+				if (x.slot[b] != 0) {
+					keys[count] = uint8_t(b);
+					idx[count] = x.idx[x.slot[b] - 1];
+					++count;
+				}
+			}
+		}
+		break;
+	case TAB256:
+		{
+			const table256 &x = m_tab256[table_at(t)];
+			for (uint64_t b = 0; b < NUM_ENTRIES_IN_TABLE; ++b) {
+				if (x.idx[b].type() != index::NIL) {
+					keys[count] = uint8_t(b);
+					idx[count] = x.idx[b];
+					++count;
+				}
+			}
+		}
+		break;
+	}
+	return count;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::fill(index t, const uint8_t *keys, const index *idx, uint64_t count)
+{
+	switch (table_size(t)) {
+	case TAB4:
+		{
+			table4 &x = m_tab4[table_at(t)];
+			for (uint64_t i = 0; i < count; ++i) {
+				x.key[i] = keys[i];
+				x.idx[i] = idx[i];
+			}
+		}
+		break;
+	case TAB16:
+		{
+			table16 &x = m_tab16[table_at(t)];
+			for (uint64_t i = 0; i < count; ++i) {
+				x.key[i] = keys[i];
+				x.idx[i] = idx[i];
+			}
+		}
+		break;
+	case TAB48:
+		{
+			table48 &x = m_tab48[table_at(t)];
+			for (uint64_t i = 0; i < count; ++i) {
+				x.slot[keys[i]] = uint8_t(i + 1);
+				x.idx[i] = idx[i];
+			}
+		}
+		break;
+	case TAB256:
+		{
+			table256 &x = m_tab256[table_at(t)];
+			for (uint64_t i = 0; i < count; ++i) {
+				x.idx[keys[i]] = idx[i];
+			}
+		}
+		break;
+	}
+	get_head(t).refs = uint16_t(count);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::trie<key_t, value_t, policy_t>::index cc0::internal::trie<key_t, value_t, policy_t>::build(uint64_t size, const uint8_t *keys, const index *idx, uint64_t count)
+{
+	const index t = new_table(size);
+	fill(t, keys, idx, count);
+	return t;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::trie<key_t, value_t, policy_t>::index *cc0::internal::trie<key_t, value_t, policy_t>::locate(index t, uint8_t b)
+{
+	switch (table_size(t)) {
+	case TAB4:
+		{
+			table4 &x = m_tab4[table_at(t)];
+			for (uint64_t i = 0; i < x.h.refs; ++i) {
+				if (x.key[i] == b) { return x.idx + i; }
+			}
+		}
+		break;
+	case TAB16:
+		{
+			table16 &x = m_tab16[table_at(t)];
+			for (uint64_t i = 0; i < x.h.refs; ++i) {
+				if (x.key[i] == b) { return x.idx + i; }
+			}
+		}
+		break;
+	case TAB48:
+		{
+			table48 &x = m_tab48[table_at(t)];
+			if (x.slot[b] != 0) { return x.idx + x.slot[b] - 1; }
+		}
+		break;
+	case TAB256:
+		return m_tab256[table_at(t)].idx + b;
+	}
+	return nullptr;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+const typename cc0::internal::trie<key_t, value_t, policy_t>::index *cc0::internal::trie<key_t, value_t, policy_t>::locate(index t, uint8_t b) const
+{
+	return const_cast<trie*>(this)->locate(t, b);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::trie<key_t, value_t, policy_t>::index cc0::internal::trie<key_t, value_t, policy_t>::find(index t, uint8_t b) const
+{
+	const index *i = locate(t, b);
+	return i != nullptr ? *i : index::make(index::NIL, 0);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::set(index t, uint8_t b, index i)
+{
+	*locate(t, b) = i;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::erase(index t, uint8_t b)
+{
+	switch (table_size(t)) {
+	case TAB4:
+		{
+			table4 &x = m_tab4[table_at(t)];
+			uint64_t i = 0;
+			while (x.key[i] != b) {
+				++i;
+			}
+			for (--x.h.refs; i < x.h.refs; ++i) {
+				x.key[i] = x.key[i + 1];
+				x.idx[i] = x.idx[i + 1];
+			}
+		}
+		return;
+	case TAB16:
+		{
+			table16 &x = m_tab16[table_at(t)];
+			uint64_t i = 0;
+			while (x.key[i] != b) {
+				++i;
+			}
+			for (--x.h.refs; i < x.h.refs; ++i) {
+				x.key[i] = x.key[i + 1];
+				x.idx[i] = x.idx[i + 1];
+			}
+		}
+		return;
+	case TAB48:
+		{
+			table48 &x = m_tab48[table_at(t)];
+			x.idx[x.slot[b] - 1] = index::make(index::NIL, 0);
+			x.slot[b] = 0;
+			--x.h.refs;
+		}
+		return;
+	case TAB256:
+		{
+			table256 &x = m_tab256[table_at(t)];
+			x.idx[b] = index::make(index::NIL, 0);
+			--x.h.refs;
+		}
+		return;
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::trie<key_t, value_t, policy_t>::index cc0::internal::trie<key_t, value_t, policy_t>::add(index t, uint8_t b, index i)
+{
+	if (table_size(t) != TAB256 && get_head(t).refs == capacity(t)) { // NOTE: The table is full. Grow it into the next size.
+		uint8_t keys[NUM_ENTRIES_IN_TABLE];
+		index   idx[NUM_ENTRIES_IN_TABLE];
+		const uint64_t count = gather(t, keys, idx);
+		const index g = build(table_size(t) + 1, keys, idx, count);
+		copy_prefix(g, t);
+		free_table(t);
+		t = g;
+	}
+	switch (table_size(t)) {
+	case TAB4:
+		{
+			table4 &x = m_tab4[table_at(t)];
+			uint64_t j = x.h.refs;
+			for (; j > 0 && x.key[j - 1] > b; --j) {
+				x.key[j] = x.key[j - 1];
+				x.idx[j] = x.idx[j - 1];
+			}
+			x.key[j] = b;
+			x.idx[j] = i;
+		}
+		break;
+	case TAB16:
+		{
+			table16 &x = m_tab16[table_at(t)];
+			uint64_t j = x.h.refs;
+			for (; j > 0 && x.key[j - 1] > b; --j) {
+				x.key[j] = x.key[j - 1];
+				x.idx[j] = x.idx[j - 1];
+			}
+			x.key[j] = b;
+			x.idx[j] = i;
+		}
+		break;
+	case TAB48:
+		{
+			table48 &x = m_tab48[table_at(t)];
+			uint64_t j = 0;
+			while (x.idx[j].type() != index::NIL) {
+				++j;
+			}
+			x.slot[b] = uint8_t(j + 1);
+			x.idx[j] = i;
+		}
+		break;
+	case TAB256:
+		m_tab256[table_at(t)].idx[b] = i;
+		break;
+	}
+	++get_head(t).refs;
+	return t;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::trie<key_t, value_t, policy_t>::index cc0::internal::trie<key_t, value_t, policy_t>::shrink(index t)
+{
+	// NOTE: Tables shrink at a lower fill rate than they grow at to avoid tables alternating between two sizes when inserting and removing around the limit.
+	const uint64_t refs = get_head(t).refs;
+	const uint64_t size = table_size(t);
+	if (size == TAB4 || (size == TAB16 && refs > 3) || (size == TAB48 && refs > 12) || (size == TAB256 && refs > 36)) {
+		return t;
+	}
+	uint8_t keys[NUM_ENTRIES_IN_TABLE];
+	index   idx[NUM_ENTRIES_IN_TABLE];
+	const uint64_t count = gather(t, keys, idx);
+	const index s = build(size - 1, keys, idx, count);
+	copy_prefix(s, t);
+	free_table(t);
+	return s;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::trie<key_t, value_t, policy_t>::index cc0::internal::trie<key_t, value_t, policy_t>::collapse(index t)
+{
+	// NOTE: A table with a single value or table left in it is replaced by that value or table.
+	if (get_head(t).refs > 1) {
+		return t;
+	}
+	uint8_t keys[NUM_ENTRIES_IN_TABLE];
+	index   idx[NUM_ENTRIES_IN_TABLE];
+	const uint64_t count = gather(t, keys, idx);
+	const index c = count > 0 ? idx[0] : index::make(index::NIL, 0);
+	const uint8_t b = count > 0 ? keys[0] : 0;
+	if (c.type() == index::TAB) { // NOTE: The remaining table now also skips the skipped bytes of the collapsed table as well as the byte the collapsed table branched on.
+		const head &h = get_head(t);
+		const head &n = get_head(c);
+		uint8_t prefix[NUM_PREFIX_BYTES];
+		uint64_t p = 0;
+		for (; p < h.skip && p < NUM_PREFIX_BYTES; ++p) {
+			prefix[p] = h.prefix[p];
+		}
+		if (p < NUM_PREFIX_BYTES) {
+			prefix[p++] = b;
+		}
+		for (uint64_t i = 0; i < n.skip && p < NUM_PREFIX_BYTES; ++i) {
+			prefix[p++] = n.prefix[i];
+		}
+		set_prefix(c, prefix, uint64_t(h.skip) + 1 + n.skip);
+	}
+	free_table(t);
+	return c;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::set_prefix(index t, const uint8_t *prefix, uint64_t skip)
+{
+	head &h = get_head(t);
+	h.skip = uint32_t(skip);
+	for (uint64_t i = 0; i < skip && i < NUM_PREFIX_BYTES; ++i) {
+		h.prefix[i] = prefix[i];
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::set_prefix(index t, const path &k, uint64_t level, uint64_t skip)
+{
+	head &h = get_head(t);
+	h.skip = uint32_t(skip);
+	for (uint64_t i = 0; i < skip && i < NUM_PREFIX_BYTES; ++i) {
+		h.prefix[i] = k[level + i];
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::copy_prefix(index dst, index src)
+{
+	const head &s = get_head(src);
+	set_prefix(dst, s.prefix, s.skip);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::trie<key_t, value_t, policy_t>::index cc0::internal::trie<key_t, value_t, policy_t>::any_leaf(index t) const
+{
+	while (t.type() == index::TAB) {
+		uint8_t keys[NUM_ENTRIES_IN_TABLE];
+		index   idx[NUM_ENTRIES_IN_TABLE];
+		gather(t, keys, idx);
+		t = idx[0];
+	}
+	return t;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::trie<key_t, value_t, policy_t>::mismatch(index t, const path &k, uint64_t level) const
+{
+	const head &h = get_head(t);
+	uint64_t i = 0;
+	for (; i < h.skip && i < NUM_PREFIX_BYTES; ++i) {
+		if (h.prefix[i] != k[level + i]) { return i; }
+	}
+	if (i < h.skip) {
+		const index a = any_leaf(t);
+		const path l(key(a));
+		for (; i < h.skip; ++i) {
+			if (l[level + i] != k[level + i]) { return i; }
+		}
+	}
+	return i;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::trie<key_t, value_t, policy_t>::index cc0::internal::trie<key_t, value_t, policy_t>::split(index t, const key_t &k, uint64_t f, const path &pk, uint64_t level, uint64_t p, index &l)
+{
+	// NOTE: The key differs from the skipped bytes of the table at position p. Put a new table in front of the table that skips the bytes before p and branches on p.
+	const head &h = get_head(t);
+	const uint64_t skip = h.skip;
+	uint8_t prefix[NUM_PREFIX_BYTES + 1];
+	if (skip <= NUM_PREFIX_BYTES) {
+		for (uint64_t i = p; i < skip; ++i) {
+			prefix[i - p] = h.prefix[i];
+		}
+	} else {
+		const index a = any_leaf(t);
+		const path la(key(a));
+		for (uint64_t i = p; i < skip && i - p <= NUM_PREFIX_BYTES; ++i) {
+			prefix[i - p] = la[level + i];
+		}
+	}
+	set_prefix(t, prefix + 1, skip - p - 1);
+	const index n = new_table(TAB4);
+	set_prefix(n, pk, level, p);
+	l = leaf(k, f);
+	return add(add(n, prefix[0], t), pk[level + p], l);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::trie<key_t, value_t, policy_t>::index cc0::internal::trie<key_t, value_t, policy_t>::leaf(const key_t &k, uint64_t f)
+{
+	++m_size;
+	if (INLINE) {
+		index l = index::make(index::INL, 0);
+		l.set(k);
+		return l;
+	}
+	return index::make(index::VAL, m_vals.add(k), f);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::release(index l)
+{
+	--m_size;
+	if (l.type() == index::VAL) {
+		m_vals.remove(l.at());
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+bool cc0::internal::trie<key_t, value_t, policy_t>::cmp(const index &l, const key_t &k, uint64_t f) const
+{
+	switch (l.type()) {
+	case index::VAL: return l.fingerprint() == f && m_vals.cmp(l.at(), k);
+	case index::INL: return l.cmp(k);
+	}
+	return false;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+const key_t &cc0::internal::trie<key_t, value_t, policy_t>::key(const index &l) const
+{
+	return l.type() == index::INL ? *l.key() : m_vals.key(l.at());
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+value_t &cc0::internal::trie<key_t, value_t, policy_t>::value(index &l)
+{
+	return l.type() == index::INL ? *l.value() : m_vals.value(l.at());
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+const value_t &cc0::internal::trie<key_t, value_t, policy_t>::value(const index &l) const
+{
+	return l.type() == index::INL ? *l.value() : m_vals.value(l.at());
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+value_t &cc0::internal::trie<key_t, value_t, policy_t>::placed(index t, uint8_t b, index l)
+{
+	// NOTE: Inline values live in the table slot they were just placed in rather than in the copy of the index held by the caller.
+	if (l.type() == index::VAL) {
+		return m_vals.value(l.at());
+	}
+	return value(t.type() == index::TAB ? *locate(t, b) : m_root);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::trie<key_t, value_t, policy_t>::fingerprint(const key_t &k)
+{
+	return FINGERPRINT_BITS > 0 ? cc0::internal::hash(k) >> ((64 - FINGERPRINT_BITS) % 64) : 0;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::prefetch(index i, uint8_t b, uint64_t f) const
+{
+	// NOTE: Fetch the cache lines needed for the next step of a look-up as soon as the index is known. For tables, guess that the table does not skip any bytes, and fetch the index the table would branch to in parallel with the header. Values whose fingerprint does not match the key are not fetched, since the key comparison fails without reading them.
+	switch (i.type()) {
+	case index::VAL:
+		if (i.fingerprint() == f) {
+			m_vals.prefetch(i.at());
+		}
+		break;
+	case index::TAB:
+		switch (table_size(i)) {
+		case TAB4:
+			CC0_DICT_PREFETCH(&m_tab4[table_at(i)]);
+			break;
+		case TAB16:
+			CC0_DICT_PREFETCH(&m_tab16[table_at(i)].h);
+			CC0_DICT_PREFETCH(&m_tab16[table_at(i)].idx[15]);
+			break;
+		case TAB48:
+			CC0_DICT_PREFETCH(&m_tab48[table_at(i)].h);
+			CC0_DICT_PREFETCH(&m_tab48[table_at(i)].slot[b]);
+			break;
+		case TAB256:
+			CC0_DICT_PREFETCH(&m_tab256[table_at(i)].h);
+			CC0_DICT_PREFETCH(&m_tab256[table_at(i)].idx[b]);
+			break;
+		}
+		break;
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::replace(index t, uint8_t b, index i)
+{
+	if (t.type() == index::TAB) {
+		set(t, b, i);
+	} else {
+		m_root = i;
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+const value_t *cc0::internal::trie<key_t, value_t, policy_t>::lookup(const key_t &k) const
+{
+	// NOTE: The fingerprint of the key is computed once, and compared against every value index met on the way.
+	const path key(k);
+	const uint64_t f = fingerprint(k);
+	const index *i = &m_root;
+	uint64_t level = 0;
+	while (i->type() == index::TAB) {
+		const head &h = get_head(*i);
+		for (uint64_t j = 0; j < h.skip && j < NUM_PREFIX_BYTES; ++j) {
+			if (h.prefix[j] != key[level + j]) { return nullptr; }
+		}
+		level += h.skip;
+		i = locate(*i, key[level]);
+		if (i == nullptr) { return nullptr; }
+		++level;
+		prefetch(*i, level < path::DEPTH ? key[level] : 0, f);
+	}
+	return cmp(*i, k, f) ? &value(*i) : nullptr;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+value_t &cc0::internal::trie<key_t, value_t, policy_t>::lookup_or_alloc(const key_t &k)
+{
+	// NOTE: Keep track of the table and key byte that refers to the current index so that the reference can be updated if the current index is replaced.
+	const path key(k);
+	const uint64_t f = fingerprint(k);
+	index parent = index::make(index::NIL, 0);
+	uint8_t pb = 0;
+	index *i = &m_root;
+	uint64_t level = 0;
+	while (i->type() == index::TAB) {
+		const index t = *i;
+		const head &h = get_head(t);
+		const uint64_t p = mismatch(t, key, level);
+		if (p < h.skip) {
+			index l;
+			const index n = split(t, k, f, key, level, p, l);
+			replace(parent, pb, n);
+			return placed(n, key[level + p], l);
+		}
+		level += h.skip;
+		const uint8_t b = key[level];
+		index *c = locate(t, b);
+		if (c == nullptr || c->type() == index::NIL) {
+			const index l = leaf(k, f);
+			const index n = add(t, b, l);
+			if (n.w != t.w) {
+				replace(parent, pb, n);
+			}
+			return placed(n, b, l);
+		}
+		parent = t;
+		pb = b;
+		i = c;
+		++level;
+		prefetch(*i, level < path::DEPTH ? key[level] : 0, f);
+	}
+	if (cmp(*i, k, f)) {
+		return value(*i);
+	}
+	return alloc(parent, pb, *i, k, f, key, level);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+value_t &cc0::internal::trie<key_t, value_t, policy_t>::alloc(index parent, uint8_t pb, index i, const key_t &k, uint64_t f, const path &pk, uint64_t level)
+{
+	switch (i.type()) {
+	case index::VAL: // Collision!
+	case index::INL:
+		{
+			// NOTE: Create a single table that skips all bytes the keys have in common, and branches on the first byte that differs.
+			const path a(key(i));
+			uint64_t d = level;
+			while (a[d] == pk[d]) {
+				++d;
+			}
+			const uint8_t ad = a[d];
+			index t = new_table(TAB4);
+			set_prefix(t, pk, level, d - level);
+			const index l = leaf(k, f);
+			t = add(add(t, ad, i), pk[d], l);
+			replace(parent, pb, t);
+			return placed(t, pk[d], l);
+		}
+	}
+	const index l = leaf(k, f);
+	replace(parent, pb, l);
+	return placed(parent, pb, l);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::trie<key_t, value_t, policy_t>::trie( void ) : m_tab4(16), m_tab16(8), m_tab48(4), m_tab256(1), m_root(index::make(index::NIL, 0)), m_size(0)
+{
+	for (uint64_t i = 0; i < 4; ++i) {
+		m_free[i] = index::make(index::NIL, 0);
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::trie<key_t, value_t, policy_t>::trie(const trie<key_t, value_t, policy_t> &d) : m_vals(d.m_vals), m_tab4(d.m_tab4), m_tab16(d.m_tab16), m_tab48(d.m_tab48), m_tab256(d.m_tab256), m_root(d.m_root), m_size(d.m_size)
+{
+	for (uint64_t i = 0; i < 4; ++i) {
+		m_free[i] = d.m_free[i];
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::trie<key_t, value_t, policy_t> &cc0::internal::trie<key_t, value_t, policy_t>::operator=(const trie<key_t, value_t, policy_t> &d)
+{
+	if (&d != this) {
+		m_vals = d.m_vals;
+		m_tab4 = d.m_tab4;
+		m_tab16 = d.m_tab16;
+		m_tab48 = d.m_tab48;
+		m_tab256 = d.m_tab256;
+		for (uint64_t i = 0; i < 4; ++i) {
+			m_free[i] = d.m_free[i];
+		}
+		m_root = d.m_root;
+		m_size = d.m_size;
+	}
+	return *this;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::trie<key_t, value_t, policy_t>::trie(trie<key_t, value_t, policy_t> &&d) noexcept : m_vals(static_cast<typename policy_t::layout::template type<key_t, value_t, policy_t>&&>(d.m_vals)), m_tab4(static_cast<array<table4>&&>(d.m_tab4)), m_tab16(static_cast<array<table16>&&>(d.m_tab16)), m_tab48(static_cast<array<table48>&&>(d.m_tab48)), m_tab256(static_cast<array<table256>&&>(d.m_tab256)), m_root(d.m_root), m_size(d.m_size)
+{
+	for (uint64_t i = 0; i < 4; ++i) {
+		m_free[i] = d.m_free[i];
+		d.m_free[i] = index::make(index::NIL, 0);
+	}
+	d.m_root = index::make(index::NIL, 0);
+	d.m_size = 0;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::trie<key_t, value_t, policy_t> &cc0::internal::trie<key_t, value_t, policy_t>::operator=(trie<key_t, value_t, policy_t> &&d) noexcept
+{
+	if (&d != this) {
+		m_vals = static_cast<typename policy_t::layout::template type<key_t, value_t, policy_t>&&>(d.m_vals);
+		m_tab4 = static_cast<array<table4>&&>(d.m_tab4);
+		m_tab16 = static_cast<array<table16>&&>(d.m_tab16);
+		m_tab48 = static_cast<array<table48>&&>(d.m_tab48);
+		m_tab256 = static_cast<array<table256>&&>(d.m_tab256);
+		for (uint64_t i = 0; i < 4; ++i) {
+			m_free[i] = d.m_free[i];
+			d.m_free[i] = index::make(index::NIL, 0);
+		}
+		m_root = d.m_root;
+		m_size = d.m_size;
+		d.m_root = index::make(index::NIL, 0);
+		d.m_size = 0;
+	}
+	return *this;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+const value_t *cc0::internal::trie<key_t, value_t, policy_t>::operator[](const key_t &key) const
+{
+	return lookup(key);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+value_t *cc0::internal::trie<key_t, value_t, policy_t>::operator[](const key_t &key)
+{
+	return const_cast<value_t*>(lookup(key));
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::lookup_batch(const key_t *keys, uint64_t n, const value_t **out) const
+{
+	// NOTE: Up to NUM_BATCH_LOOKUPS look-ups are in flight at a time. Each visit advances a look-up by one step and prefetches what the next step needs, so by the time the look-up is visited again its memory is likely in cache. A finished look-up is immediately replaced by the next key.
+	const index *i[NUM_BATCH_LOOKUPS];
+	path         key[NUM_BATCH_LOOKUPS];
+	uint64_t     f[NUM_BATCH_LOOKUPS];
+	uint64_t     level[NUM_BATCH_LOOKUPS];
+	uint64_t     key_at[NUM_BATCH_LOOKUPS];
+	uint64_t     active = 0;
+	uint64_t     next = 0;
+	while (active < NUM_BATCH_LOOKUPS && next < n) {
+		i[active] = &m_root;
+		key[active] = path(keys[next]);
+		f[active] = fingerprint(keys[next]);
+		level[active] = 0;
+		key_at[active] = next;
+		prefetch(m_root, key[active][0], f[active]);
+		++active;
+		++next;
+	}
+	while (active > 0) {
+		for (uint64_t a = 0; a < active;) {
+			if (i[a] != nullptr && i[a]->type() == index::TAB) {
+				const head &h = get_head(*i[a]);
+				uint64_t j = 0;
+				while (j < h.skip && j < NUM_PREFIX_BYTES && h.prefix[j] == key[a][level[a] + j]) {
+					++j;
+				}
+				if (j < h.skip && j < NUM_PREFIX_BYTES) {
+					i[a] = nullptr;
+				} else {
+					level[a] += h.skip;
+					i[a] = locate(*i[a], key[a][level[a]]);
+					++level[a];
+					if (i[a] != nullptr) {
+						prefetch(*i[a], level[a] < path::DEPTH ? key[a][level[a]] : 0, f[a]);
+					}
+				}
+				++a;
+				continue;
+			}
+			out[key_at[a]] = (i[a] != nullptr && cmp(*i[a], keys[key_at[a]], f[a])) ? &value(*i[a]) : nullptr;
+			if (next < n) {
+				i[a] = &m_root;
+				key[a] = path(keys[next]);
+				f[a] = fingerprint(keys[next]);
+				level[a] = 0;
+				key_at[a] = next;
+				prefetch(m_root, key[a][0], f[a]);
+				++next;
+				++a;
+			} else {
+				--active;
+				i[a] = i[active];
+				key[a] = key[active];
+				f[a] = f[active];
+				level[a] = level[active];
+				key_at[a] = key_at[active];
+			}
+		}
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::lookup_batch(const key_t *keys, uint64_t n, value_t **out)
+{
+	static_cast<const trie*>(this)->lookup_batch(keys, n, const_cast<const value_t**>(out));
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+const value_t &cc0::internal::trie<key_t, value_t, policy_t>::operator()(const key_t &key) const
+{
+	return *lookup(key);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+value_t &cc0::internal::trie<key_t, value_t, policy_t>::operator()(const key_t &key)
+{
+	return insert(key);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+value_t &cc0::internal::trie<key_t, value_t, policy_t>::insert(const key_t &key)
+{
+	return lookup_or_alloc(key);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::remove(const key_t &key)
+{
+	// NOTE: Keep track of the two last tables visited. The table containing the value may shrink or collapse once the value is removed, which means the table referring to it must be updated.
+	const path k(key);
+	const uint64_t f = fingerprint(key);
+	index grandparent = index::make(index::NIL, 0);
+	index parent = index::make(index::NIL, 0);
+	uint8_t gb = 0;
+	uint8_t pb = 0;
+	index i = m_root;
+	uint64_t level = 0;
+	while (i.type() == index::TAB) {
+		level += get_head(i).skip;
+		grandparent = parent;
+		gb = pb;
+		parent = i;
+		pb = k[level];
+		i = find(i, pb);
+		++level;
+		prefetch(i, level < path::DEPTH ? k[level] : 0, f);
+	}
+	if (!cmp(i, key, f)) {
+		return;
+	}
+	release(i);
+	if (parent.type() != index::TAB) {
+		m_root = index::make(index::NIL, 0);
+		return;
+	}
+	erase(parent, pb);
+	const index n = collapse(shrink(parent));
+	if (n.w != parent.w) {
+		replace(grandparent, gb, n);
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::clear( void )
+{
+	m_vals.clear();
+	m_tab4.truncate(0);
+	m_tab16.truncate(0);
+	m_tab48.truncate(0);
+	m_tab256.truncate(0);
+	for (uint64_t i = 0; i < 4; ++i) {
+		m_free[i] = index::make(index::NIL, 0);
+	}
+	m_root = index::make(index::NIL, 0);
+	m_size = 0;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::reserve(uint64_t entries, uint64_t tables)
+{
+	if (!INLINE) {
+		m_vals.reserve(entries);
+	}
+	uint64_t n[4];
+	estimate_tables(entries, n);
+	if (tables > 0) {
+		const uint64_t total = n[TAB4] + n[TAB16] + n[TAB48] + n[TAB256];
+		if (total > 0) {
+			for (uint64_t s = 0; s < 4; ++s) {
+				n[s] = uint64_t(double(n[s]) * double(tables) / double(total) + 0.999);
+			}
+		} else {
+			n[TAB4] = tables;
+		}
+	}
+	// NOTE: The estimate is usually within a few percent for hashed keys. A margin is added on top, so that a bulk load rarely has to grow the tables anyway.
+	reserve_tables(m_tab4, n[TAB4] + n[TAB4] / 16 + 4);
+	reserve_tables(m_tab16, n[TAB16] + n[TAB16] / 16 + 4);
+	reserve_tables(m_tab48, n[TAB48] + n[TAB48] / 16 + 4);
+	reserve_tables(m_tab256, n[TAB256] + n[TAB256] / 16 + 4);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::compact( void )
+{
+	trie c;
+	uint64_t n[4] = { 0, 0, 0, 0 };
+	count_fit(m_tab4, n);
+	count_fit(m_tab16, n);
+	count_fit(m_tab48, n);
+	count_fit(m_tab256, n);
+	reserve_tables(c.m_tab4, n[TAB4]);
+	reserve_tables(c.m_tab16, n[TAB16]);
+	reserve_tables(c.m_tab48, n[TAB48]);
+	reserve_tables(c.m_tab256, n[TAB256]);
+	if (!INLINE) {
+		c.m_vals.reserve(m_size);
+	}
+	// NOTE: Tables are allocated in the order they are discovered, which is breadth-first, and filled in once they are taken off the queue.
+	array<index> queue(1);
+	queue.reserve((n[TAB4] + n[TAB16] + n[TAB48] + n[TAB256]) * 2);
+	c.m_root = c.adopt(*this, m_root, queue);
+	for (uint64_t q = 0; q < queue.size(); q += 2) {
+		uint8_t keys[NUM_ENTRIES_IN_TABLE];
+		index   idx[NUM_ENTRIES_IN_TABLE];
+		const uint64_t count = gather(queue[q], keys, idx);
+		for (uint64_t i = 0; i < count; ++i) {
+			idx[i] = c.adopt(*this, idx[i], queue);
+		}
+		const index t = queue[q + 1];
+		c.fill(t, keys, idx, count);
+		const head &h = get_head(queue[q]);
+		c.set_prefix(t, h.prefix, h.skip);
+	}
+	c.m_size = m_size;
+	*this = static_cast<trie&&>(c);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+bool cc0::internal::trie<key_t, value_t, policy_t>::defrag_step(uint64_t budget)
+{
+	// NOTE: Every step is charged one unit of the budget. Releasing storage is charged one more unit per element it moves.
+	while (budget > 0) {
+		--budget;
+		if (!pack_values(budget) && !pack_tables(m_tab4, TAB4, budget) && !pack_tables(m_tab16, TAB16, budget) && !pack_tables(m_tab48, TAB48, budget) && !pack_tables(m_tab256, TAB256, budget)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::trie<key_t, value_t, policy_t>::allocated_bytes( void ) const
+{
+	return
+		m_vals.allocated_bytes() +
+		m_tab4.pool_size() * sizeof(table4) +
+		m_tab16.pool_size() * sizeof(table16) +
+		m_tab48.pool_size() * sizeof(table48) +
+		m_tab256.pool_size() * sizeof(table256);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+template < typename table_t >
+uint64_t cc0::internal::trie<key_t, value_t, policy_t>::used_tables(const array<table_t> &tabs)
+{
+	uint64_t t = 0;
+	for (uint64_t i = 0; i < tabs.size(); ++i) {
+		if (tabs[i].h.refs) {
+			++t;
+		}
+	}
+	return t;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+template < typename table_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::reserve_tables(array<table_t> &tabs, uint64_t n)
+{
+	if (n > tabs.pool_size()) {
+		tabs.resize_pool(n);
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::trie<key_t, value_t, policy_t>::fit(uint64_t refs)
+{
+	return refs <= 4 ? TAB4 : (refs <= 16 ? TAB16 : (refs <= 48 ? TAB48 : TAB256));
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+template < typename table_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::count_fit(const array<table_t> &tabs, uint64_t *tables)
+{
+	for (uint64_t i = 0; i < tabs.size(); ++i) {
+		if (tabs[i].h.refs) {
+			++tables[fit(tabs[i].h.refs)];
+		}
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::trie<key_t, value_t, policy_t>::index cc0::internal::trie<key_t, value_t, policy_t>::adopt(trie &src, index i, array<index> &queue)
+{
+	switch (i.type()) {
+	case index::VAL:
+		{
+			const uint64_t e = m_vals.add(src.m_vals.key(i.at()));
+			m_vals.value(e) = static_cast<value_t&&>(src.m_vals.value(i.at()));
+			return index::make(index::VAL, e, i.fingerprint());
+		}
+	case index::TAB:
+		{
+			const index t = new_table(fit(src.get_head(i).refs));
+			queue.add(i);
+			queue.add(t);
+			return t;
+		}
+	}
+	return i;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::trie<key_t, value_t, policy_t>::index *cc0::internal::trie<key_t, value_t, policy_t>::leaf_slot(const key_t &k)
+{
+	const path key(k);
+	index *i = &m_root;
+	uint64_t level = 0;
+	while (i->type() == index::TAB) {
+		level += get_head(*i).skip;
+		i = locate(*i, key[level]);
+		++level;
+	}
+	return i;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::trie<key_t, value_t, policy_t>::index *cc0::internal::trie<key_t, value_t, policy_t>::table_slot(index t)
+{
+	// NOTE: The path to any value in the table leads through the index referring to the table.
+	const index a = any_leaf(t);
+	const path key(this->key(a));
+	index *i = &m_root;
+	uint64_t level = 0;
+	while (i->w != t.w) {
+		level += get_head(*i).skip;
+		i = locate(*i, key[level]);
+		++level;
+	}
+	return i;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+bool cc0::internal::trie<key_t, value_t, policy_t>::pack_values(uint64_t &budget)
+{
+	uint64_t from, to;
+	if (!m_vals.pack(from, to, budget)) {
+		return false;
+	}
+	if (from != to) {
+		index *l = leaf_slot(m_vals.key(from));
+		*l = index::make(index::VAL, to, l->fingerprint());
+		m_vals.relocate(from, to);
+	}
+	return true;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+template < typename table_t >
+bool cc0::internal::trie<key_t, value_t, policy_t>::pack_tables(array<table_t> &tabs, uint64_t size, uint64_t &budget)
+{
+	const uint64_t end = tabs.size();
+	if (end > 0 && tabs[end - 1].h.refs == 0) {
+		// NOTE: A free table at the end is released rather than filled. The free list is doubly linked, so it is unlinked without walking the list.
+		unlink_table(tabs, make_table(size, end - 1));
+		tabs.truncate(end - 1);
+		return true;
+	}
+	if (m_free[size].type() != index::TAB) {
+		return tabs.shrink_pool(budget);
+	}
+	const index to = m_free[size];
+	unlink_table(tabs, to);
+	*table_slot(make_table(size, end - 1)) = to;
+	tabs[table_at(to)] = tabs[end - 1];
+	tabs.truncate(end - 1);
+	return true;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+template < typename trie_t, typename func_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::for_each(trie_t &d, func_t &f)
+{
+	// NOTE: The dictionary is passed in as either const or non-const, which selects whether values are passed to the function as const.
+	d.m_vals.for_each(f);
+	if (INLINE) {
+		if (d.m_root.type() == index::INL) {
+			visit(d, d.m_root, f);
+		}
+		for_each_inline(d, d.m_tab4, TAB4, f);
+		for_each_inline(d, d.m_tab16, TAB16, f);
+		for_each_inline(d, d.m_tab48, TAB48, f);
+		for_each_inline(d, d.m_tab256, TAB256, f);
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+template < typename trie_t, typename index_t, typename func_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::visit(trie_t &d, index_t &l, func_t &f)
+{
+	f(d.key(l), d.value(l));
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+template < typename trie_t, typename tables_t, typename func_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::for_each_inline(trie_t &d, tables_t &tabs, uint64_t size, func_t &f)
+{
+	for (uint64_t i = 0; i < tabs.size(); ++i) {
+		if (tabs[i].h.refs == 0) {
+			continue;
+		}
+		const index t = make_table(size, i);
+		uint8_t keys[NUM_ENTRIES_IN_TABLE];
+		index   idx[NUM_ENTRIES_IN_TABLE];
+		const uint64_t count = d.gather(t, keys, idx);
+		for (uint64_t j = 0; j < count; ++j) {
+			if (idx[j].type() == index::INL) {
+				// NOTE: The gathered index is a copy, so the function is passed the value in the table slot itself.
+				visit(d, *d.locate(t, keys[j]), f);
+			}
+		}
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::estimate_level(uint64_t n, double buckets, double *tables)
+{
+	// NOTE: The keys are spread over a number of buckets, one per distinct path up to this level. The number of keys in a bucket follows a binomial distribution. Its probabilities are computed relative to the most likely number of keys from the ratios between neighbouring probabilities, and normalized at the end, so that no exponentials are needed. A bucket with k keys needs a table unless all of its keys share the next byte, in which case the byte is skipped by a table further down. The table branches on the expected number of distinct bytes among k random bytes.
+	if (n < 2) {
+		return;
+	}
+	double sum[4] = { 0.0, 0.0, 0.0, 0.0 };
+	double total = 0.0;
+	const double r = buckets > 1.0 ? 1.0 / (buckets - 1.0) : 0.0; // The probability that a key lands in a given bucket, divided by the probability that it does not.
+	const uint64_t peak = buckets > 1.0 ? uint64_t(double(n) / buckets) : n;
+	uint64_t k = peak;
+	double w = 1.0;
+	while (r > 0.0 && k > 0 && w >= 1e-9) {
+		w *= double(k) / (double(n - k + 1) * r);
+		--k;
+	}
+	while (k <= peak || w >= 1e-9) {
+		total += w;
+		if (k >= 2) {
+			const double branches = 256.0 * (1.0 - power(255.0 / 256.0, k));
+			const uint64_t size = branches <= 4.0 ? TAB4 : (branches <= 16.0 ? TAB16 : (branches <= 48.0 ? TAB48 : TAB256));
+			sum[size] += w * (1.0 - power(1.0 / 256.0, k - 1));
+		}
+		if (k == n || r == 0.0) {
+			break;
+		}
+		w *= double(n - k) / double(k + 1) * r;
+		++k;
+	}
+	for (uint64_t s = 0; s < 4; ++s) {
+		tables[s] += buckets * sum[s] / total;
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::estimate_tables(uint64_t entries, uint64_t *tables)
+{
+	// NOTE: Tables grow into larger sizes as keys are inserted, and their old slots are reused by new tables of the smaller size. The number of tables of a size allocated after inserting n keys is therefore the highest number in use at any point during insertion, rather than the number in use at the end. That number is approximated by estimating the tables in use at every 1/8th step down from n.
+	for (uint64_t s = 0; s < 4; ++s) {
+		tables[s] = 0;
+	}
+	for (uint64_t n = entries; n >= 2; n -= n / 8 > 0 ? n / 8 : 1) {
+		double t[4] = { 0.0, 0.0, 0.0, 0.0 };
+		double buckets = 1.0;
+		for (uint64_t level = 0; level < path::DEPTH && (level == 0 || double(n) * double(n) > buckets * 0.02); ++level) {
+			estimate_level(n, buckets, t);
+			buckets *= 256.0;
+		}
+		for (uint64_t s = 0; s < 4; ++s) {
+			const uint64_t x = uint64_t(t[s] + 0.5);
+			tables[s] = x > tables[s] ? x : tables[s];
+		}
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::trie<key_t, value_t, policy_t>::used_bytes( void ) const
+{
+	return
+		m_vals.used_bytes() +
+		used_tables(m_tab4) * sizeof(table4) +
+		used_tables(m_tab16) * sizeof(table16) +
+		used_tables(m_tab48) * sizeof(table48) +
+		used_tables(m_tab256) * sizeof(table256);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+template < typename func_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::for_each(func_t &&f)
+{
+	for_each(*this, f);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+template < typename func_t >
+void cc0::internal::trie<key_t, value_t, policy_t>::for_each(func_t &&f) const
+{
+	for_each(*this, f);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::trie<key_t, value_t, policy_t>::size( void ) const
+{
+	return m_size;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::trie<key_t, value_t, policy_t>::prof_lookup(const key_t &key, uint64_t *tables) const
+{
+	const path k(key);
+	index i = m_root;
+	uint64_t level = 0;
+	uint64_t visited = 0;
+	while (i.type() == index::TAB) {
+		level += get_head(i).skip;
+		i = find(i, k[level]);
+		++level;
+		++visited;
+	}
+	if (tables != nullptr) {
+		*tables = visited;
+	}
+	return level;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::trie<key_t, value_t, policy_t>::table_count( void ) const
+{
+	return m_tab4.size() + m_tab16.size() + m_tab48.size() + m_tab256.size();
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::trie<key_t, value_t, policy_t>::estimate_tables(uint64_t entries)
+{
+	uint64_t n[4];
+	estimate_tables(entries, n);
+	return n[TAB4] + n[TAB16] + n[TAB48] + n[TAB256];
+}
+
+//
+// critbit
+//
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::critbit<key_t, value_t, policy_t>::index cc0::internal::critbit<key_t, value_t, policy_t>::index::make(uint64_t type, uint64_t i)
+{
+	index x;
+	x.w = word_t((i << 2) | type);
+	// NOTE: Fails if the dictionary holds more values than the index policy has room for. See index32 and index64. Aborts rather than throws, since the caller has already started to modify the dictionary.
+	if (x.at() != i) {
+		cc0::internal::fatal("cc0::dict: too many values for the index policy");
+	}
+	return x;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::critbit<key_t, value_t, policy_t>::index::type( void ) const
+{
+	return uint64_t(w & 3);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::critbit<key_t, value_t, policy_t>::index::at( void ) const
+{
+	return uint64_t(w >> 2);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::critbit<key_t, value_t, policy_t>::direction(const node &n, const path &k)
+{
+	return uint64_t(k[n.bit >> 3] >> (7 - (n.bit & 7))) & 1;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::critbit<key_t, value_t, policy_t>::prefetch(index i) const
+{
+	switch (i.type()) {
+	case index::VAL:
+		m_vals.prefetch(i.at());
+		break;
+	case index::NODE:
+		CC0_DICT_PREFETCH(&m_nodes[i.at()]);
+		break;
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::critbit<key_t, value_t, policy_t>::replace(index n, uint64_t dir, index i)
+{
+	if (n.type() == index::NODE) {
+		m_nodes[n.at()].child[dir] = i;
+	} else {
+		m_root = i;
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::critbit<key_t, value_t, policy_t>::index cc0::internal::critbit<key_t, value_t, policy_t>::new_node(uint64_t bit)
+{
+	index n = m_free;
+	if (n.type() == index::NODE) {
+		unlink_node(n);
+	} else {
+		n = index::make(index::NODE, m_nodes.size());
+		m_nodes.add();
+	}
+	m_nodes[n.at()].bit = uint32_t(bit);
+	return n;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::critbit<key_t, value_t, policy_t>::free_node(index n)
+{
+	node &x = m_nodes[n.at()];
+	x.child[0] = m_free;
+	x.child[1] = index::make(index::NIL, 0);
+	x.bit = FREE;
+	if (m_free.type() == index::NODE) {
+		m_nodes[m_free.at()].child[1] = n;
+	}
+	m_free = n;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::critbit<key_t, value_t, policy_t>::unlink_node(index n)
+{
+	const node &x = m_nodes[n.at()];
+	if (x.child[1].type() == index::NODE) {
+		m_nodes[x.child[1].at()].child[0] = x.child[0];
+	} else {
+		m_free = x.child[0];
+	}
+	if (x.child[0].type() == index::NODE) {
+		m_nodes[x.child[0].at()].child[1] = x.child[1];
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::critbit<key_t, value_t, policy_t>::index *cc0::internal::critbit<key_t, value_t, policy_t>::leaf_slot(const key_t &k)
+{
+	const path key(k);
+	index *i = &m_root;
+	while (i->type() == index::NODE) {
+		node &n = m_nodes[i->at()];
+		i = &n.child[direction(n, key)];
+	}
+	return i;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::critbit<key_t, value_t, policy_t>::index *cc0::internal::critbit<key_t, value_t, policy_t>::node_slot(index n)
+{
+	// NOTE: The path to any value below the node leads through the index referring to the node.
+	index a = n;
+	while (a.type() == index::NODE) {
+		a = m_nodes[a.at()].child[0];
+	}
+	const path key(m_vals.key(a.at()));
+	index *i = &m_root;
+	while (i->w != n.w) {
+		node &x = m_nodes[i->at()];
+		i = &x.child[direction(x, key)];
+	}
+	return i;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+bool cc0::internal::critbit<key_t, value_t, policy_t>::pack_values(uint64_t &budget)
+{
+	uint64_t from, to;
+	if (!m_vals.pack(from, to, budget)) {
+		return false;
+	}
+	if (from != to) {
+		*leaf_slot(m_vals.key(from)) = index::make(index::VAL, to);
+		m_vals.relocate(from, to);
+	}
+	return true;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+bool cc0::internal::critbit<key_t, value_t, policy_t>::pack_nodes(uint64_t &budget)
+{
+	const uint64_t end = m_nodes.size();
+	if (end > 0 && m_nodes[end - 1].bit == FREE) {
+		// NOTE: A free node at the end is released rather than filled. The free list is doubly linked, so it is unlinked without walking the list.
+		unlink_node(index::make(index::NODE, end - 1));
+		m_nodes.truncate(end - 1);
+		return true;
+	}
+	if (m_free.type() != index::NODE) {
+		return m_nodes.shrink_pool(budget);
+	}
+	const index to = m_free;
+	unlink_node(to);
+	*node_slot(index::make(index::NODE, end - 1)) = to;
+	m_nodes[to.at()] = m_nodes[end - 1];
+	m_nodes.truncate(end - 1);
+	return true;
+}
 
-	public:
-		/// @brief Initializes the data structure.
-		dict( void );
-
-		/// @brief Copies a dictionary.
-		/// @param d The dictionary to copy.
-		dict(const dict &d);
-
-		/// @brief Moves data from one dictionary to another.
-		/// @param d The dictionary to move data from.
-		//dict(dict &&d);
-
-		/// @brief Copies a dictionary.
-		/// @param d The dictionary to copy.
-		/// @return A reference to self.
-		dict &operator=(const dict &d);
-
-		/// @brief Moves data from one dictionary to another.
-		/// @param d The dictionary to move data from.
-		/// @return A reference to self.
-		//dict &operator=(dict &&d);
-
-		/// @brief Returns the pointer to the value pointed to by the key. Null is returned if the key does not exist.
-		/// @param key The key.
-		/// @return The value pointed to by the key.
-		const value_t *operator[](const key_t &key) const;
-		
-		/// @brief Returns the pointer to the value pointed to by the key. Null is returned if the key does not exist.
-		/// @param key The key.
-		/// @return The value pointed to by the key.
-		value_t *operator[](const key_t &key);
-
-		/// @brief Returns a reference to the value pointed to by the key. If the value does not exist, there will be a null pointer dereference, and possibly a crash.
-		/// @param key The key.
-		/// @return The reference to the value pointed to by the key.
-		/// @warning May crash the application if the value does not exist. Only use this function if you are sure the value exists.
-		const value_t &operator()(const key_t &key) const;
-
-		/// @brief Returns a reference to the value pointed to by the key. If the value does not exist, a new value will be created making this function always safe to call (the value returned may, however, not be initialized).
-		/// @param key The key.
-		/// @return The reference to the value pointed to by the key.
-		value_t &operator()(const key_t &key);
-
-		/// @brief Returns a reference to the value pointed to by the key. If the value does not exist, a new value will be created making this function always safe to call (the value returned may, however, not be initialized).
-		/// @param key The key.
-		/// @return The reference to the value pointed to by the key.
-		value_t &insert(const key_t &key);
-
-		/// @brief Removes a value with the specified key. If the value does not exist nothing will happen.
-		/// @param key The key.
-		void remove(const key_t &key);
-
-		/// @brief Returns the total space, in bytes, allocated by the data structure.
-		/// @return  The total space, in bytes, allocated by the data structure.
-		uint64_t allocated_bytes( void ) const;
+template < typename key_t, typename value_t, typename policy_t >
+typename cc0::internal::critbit<key_t, value_t, policy_t>::index cc0::internal::critbit<key_t, value_t, policy_t>::adopt(critbit &src, index i, array<index> &queue)
+{
+	switch (i.type()) {
+	case index::VAL:
+		{
+			const uint64_t e = m_vals.add(src.m_vals.key(i.at()));
+			m_vals.value(e) = static_cast<value_t&&>(src.m_vals.value(i.at()));
+			return index::make(index::VAL, e);
+		}
+	case index::NODE:
+		{
+			const index n = new_node(src.m_nodes[i.at()].bit);
+			queue.add(i);
+			queue.add(n);
+			return n;
+		}
+	}
+	return i;
+}
 
-		/// @brief Returns the total space, in bytes, used by the data structure.
-		/// @return The total space, in bytes, used by the data structure.
-		/// @note This calculation does not completely give an accurate picture as tables containing at least one value is still marked as in use, and not partially in use.
-		uint64_t used_bytes( void ) const;
+template < typename key_t, typename value_t, typename policy_t >
+const value_t *cc0::internal::critbit<key_t, value_t, policy_t>::lookup(const key_t &k) const
+{
+	const path key(k);
+	index i = m_root;
+	while (i.type() == index::NODE) {
+		const node &n = m_nodes[i.at()];
+		i = n.child[direction(n, key)];
+		prefetch(i);
+	}
+	return (i.type() == index::VAL && m_vals.cmp(i.at(), k)) ? &m_vals.value(i.at()) : nullptr;
+}
 
-		/// @brief Returns the number of values stored in the data structure.
-		/// @return The number of values stored in the data structure.
-		uint64_t size( void ) const;
+template < typename key_t, typename value_t, typename policy_t >
+value_t &cc0::internal::critbit<key_t, value_t, policy_t>::lookup_or_alloc(const key_t &k)
+{
+	const path key(k);
+	if (m_root.type() == index::NIL) {
+		const uint64_t e = m_vals.add(k);
+		m_root = index::make(index::VAL, e);
+		return m_vals.value(e);
+	}
 
-		/// @brief Counts the number of look-ups made to find the requested value at the key.
-		/// @param key The key.
-		/// @return The number of look-ups made to find the value at the key.
-		uint64_t prof_lookup(const key_t &key) const;
+	// NOTE: The value at the end of the walk shares the longest path prefix with the key of all values. The first bit where their paths differ is where the key branches off.
+	index i = m_root;
+	while (i.type() == index::NODE) {
+		const node &n = m_nodes[i.at()];
+		i = n.child[direction(n, key)];
+		prefetch(i);
+	}
+	if (m_vals.cmp(i.at(), k)) {
+		return m_vals.value(i.at());
+	}
+	const path l(m_vals.key(i.at()));
+	uint64_t byte = 0;
+	while (l[byte] == key[byte]) {
+		++byte;
+	}
+	const uint8_t diff = l[byte] ^ key[byte];
+	uint64_t bit = byte << 3;
+	while ((diff & (0x80 >> (bit & 7))) == 0) {
+		++bit;
+	}
+	const uint64_t d = uint64_t(key[byte] >> (7 - (bit & 7))) & 1;
 
-		/// @brief Returns the number of tables currently allocated for the dictionary.
-		/// @return The number of tables currently allocated for the dictionary.
-		uint64_t table_count( void ) const;
-	};
+	// NOTE: Walk down to where the new branch belongs in the order bits are walked.
+	index parent = index::make(index::NIL, 0);
+	uint64_t pd = 0;
+	i = m_root;
+	while (i.type() == index::NODE && m_nodes[i.at()].bit < bit) {
+		parent = i;
+		pd = direction(m_nodes[i.at()], key);
+		i = m_nodes[i.at()].child[pd];
+	}
+	const uint64_t e = m_vals.add(k);
+	const index n = new_node(bit);
+	m_nodes[n.at()].child[d] = index::make(index::VAL, e);
+	m_nodes[n.at()].child[1 - d] = i;
+	replace(parent, pd, n);
+	return m_vals.value(e);
 }
 
-//
-// fnv1a64
-//
-template < typename type_t >
-cc0::internal::fnv1a64::fnv1a64(const type_t &in) : fnv1a64(&in, sizeof(in))
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::critbit<key_t, value_t, policy_t>::critbit( void ) : m_nodes(16), m_free(index::make(index::NIL, 0)), m_root(index::make(index::NIL, 0))
 {}
 
-template < typename type_t >
-cc0::internal::fnv1a64 &cc0::internal::fnv1a64::operator()(const type_t &in)
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::critbit<key_t, value_t, policy_t>::critbit(const critbit<key_t, value_t, policy_t> &d) : m_vals(d.m_vals), m_nodes(d.m_nodes), m_free(d.m_free), m_root(d.m_root)
+{}
+
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::critbit<key_t, value_t, policy_t> &cc0::internal::critbit<key_t, value_t, policy_t>::operator=(const critbit<key_t, value_t, policy_t> &d)
 {
-	ingest(&in, sizeof(in));
+	if (&d != this) {
+		m_vals = d.m_vals;
+		m_nodes = d.m_nodes;
+		m_free = d.m_free;
+		m_root = d.m_root;
+	}
 	return *this;
 }
 
-template < typename type_t >
-cc0::internal::fnv1a64 cc0::internal::fnv1a64::operator()(const type_t &in) const
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::critbit<key_t, value_t, policy_t>::critbit(critbit<key_t, value_t, policy_t> &&d) noexcept : m_vals(static_cast<typename policy_t::layout::template type<key_t, value_t, policy_t>&&>(d.m_vals)), m_nodes(static_cast<array<node>&&>(d.m_nodes)), m_free(d.m_free), m_root(d.m_root)
 {
-	return fnv1a64(*this)(in);
+	d.m_free = index::make(index::NIL, 0);
+	d.m_root = index::make(index::NIL, 0);
 }
 
-//
-// key
-//
-
-template < typename type_t >
-cc0::key<type_t>::key(const type_t &v) : k(cc0::internal::fnv1a64(&v, sizeof(v)))
-{}
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::critbit<key_t, value_t, policy_t> &cc0::internal::critbit<key_t, value_t, policy_t>::operator=(critbit<key_t, value_t, policy_t> &&d) noexcept
+{
+	if (&d != this) {
+		m_vals = static_cast<typename policy_t::layout::template type<key_t, value_t, policy_t>&&>(d.m_vals);
+		m_nodes = static_cast<array<node>&&>(d.m_nodes);
+		m_free = d.m_free;
+		m_root = d.m_root;
+		d.m_free = index::make(index::NIL, 0);
+		d.m_root = index::make(index::NIL, 0);
+	}
+	return *this;
+}
 
-//
-// array
-//
+template < typename key_t, typename value_t, typename policy_t >
+const value_t *cc0::internal::critbit<key_t, value_t, policy_t>::operator[](const key_t &key) const
+{
+	return lookup(key);
+}
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-cc0::dict<key_t, value_t>::array<type_t>::array(uint64_t growth) : m_vals(nullptr), m_size(0), m_pool(0), m_growth(growth > 0 ? growth : 1)
-{}
+template < typename key_t, typename value_t, typename policy_t >
+value_t *cc0::internal::critbit<key_t, value_t, policy_t>::operator[](const key_t &key)
+{
+	return const_cast<value_t*>(lookup(key));
+}
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-cc0::dict<key_t, value_t>::array<type_t>::array(const cc0::dict<key_t, value_t>::array<type_t> &a) : array()
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::critbit<key_t, value_t, policy_t>::lookup_batch(const key_t *keys, uint64_t n, const value_t **out) const
 {
-	resize_pool(a.m_pool);
-	resize(a.m_size);
-	for (uint64_t i = 0; i < m_size; ++i) {
-		m_vals[i] = a.m_vals[i];
+	// NOTE: Up to NUM_BATCH_LOOKUPS look-ups are in flight at a time. Each visit advances a look-up by one node and prefetches the next, so that the memory accesses of the look-ups overlap.
+	index    i[NUM_BATCH_LOOKUPS];
+	path     key[NUM_BATCH_LOOKUPS];
+	uint64_t key_at[NUM_BATCH_LOOKUPS];
+	uint64_t active = 0;
+	uint64_t next = 0;
+	while (active < NUM_BATCH_LOOKUPS && next < n) {
+		i[active] = m_root;
+		key[active] = path(keys[next]);
+		key_at[active] = next;
+		prefetch(m_root);
+		++active;
+		++next;
+	}
+	while (active > 0) {
+		for (uint64_t a = 0; a < active;) {
+			if (i[a].type() == index::NODE) {
+				const node &x = m_nodes[i[a].at()];
+				i[a] = x.child[direction(x, key[a])];
+				prefetch(i[a]);
+				++a;
+				continue;
+			}
+			out[key_at[a]] = (i[a].type() == index::VAL && m_vals.cmp(i[a].at(), keys[key_at[a]])) ? &m_vals.value(i[a].at()) : nullptr;
+			if (next < n) {
+				i[a] = m_root;
+				key[a] = path(keys[next]);
+				key_at[a] = next;
+				prefetch(m_root);
+				++next;
+				++a;
+			} else {
+				--active;
+				i[a] = i[active];
+				key[a] = key[active];
+				key_at[a] = key_at[active];
+			}
+		}
 	}
 }
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-cc0::dict<key_t, value_t>::array<type_t>::~array( void )
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::critbit<key_t, value_t, policy_t>::lookup_batch(const key_t *keys, uint64_t n, value_t **out)
 {
-	delete [] m_vals;
+	static_cast<const critbit*>(this)->lookup_batch(keys, n, const_cast<const value_t**>(out));
 }
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-cc0::dict<key_t, value_t>::array<type_t> &cc0::dict<key_t, value_t>::array<type_t>::operator=(const cc0::dict<key_t, value_t>::array<type_t> &a)
+template < typename key_t, typename value_t, typename policy_t >
+const value_t &cc0::internal::critbit<key_t, value_t, policy_t>::operator()(const key_t &key) const
 {
-	if (&a != this) {
-		resize_pool(a.m_pool);
-		resize(a.m_size);
-		for (uint64_t i = 0; i < m_size; ++i) {
-			m_vals[i] = a.m_vals[i];
-		}
-	}
-	return *this;
+	return *lookup(key);
 }
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-void cc0::dict<key_t, value_t>::array<type_t>::destroy( void )
+template < typename key_t, typename value_t, typename policy_t >
+value_t &cc0::internal::critbit<key_t, value_t, policy_t>::operator()(const key_t &key)
 {
-	delete [] m_vals;
-	m_size = 0;
-	m_pool = 0;
+	return insert(key);
 }
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-void cc0::dict<key_t, value_t>::array<type_t>::create(uint64_t size)
+template < typename key_t, typename value_t, typename policy_t >
+value_t &cc0::internal::critbit<key_t, value_t, policy_t>::insert(const key_t &key)
 {
-	reserve(size);
-	m_size = size;
+	return lookup_or_alloc(key);
 }
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-void cc0::dict<key_t, value_t>::array<type_t>::reserve(uint64_t size)
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::critbit<key_t, value_t, policy_t>::remove(const key_t &key)
 {
-	if (size > m_pool) {
-		destroy();
-		m_vals = new type_t[size];
-		m_pool = size;
+	// NOTE: Keep track of the two last nodes visited. The node branching to the value is removed, and its other subtree takes its place in the node above it.
+	const path k(key);
+	index grandparent = index::make(index::NIL, 0);
+	index parent = index::make(index::NIL, 0);
+	uint64_t gd = 0;
+	uint64_t pd = 0;
+	index i = m_root;
+	while (i.type() == index::NODE) {
+		grandparent = parent;
+		gd = pd;
+		parent = i;
+		pd = direction(m_nodes[i.at()], k);
+		i = m_nodes[i.at()].child[pd];
+		prefetch(i);
 	}
-	m_size = 0;
+	if (i.type() != index::VAL || !m_vals.cmp(i.at(), key)) {
+		return;
+	}
+	m_vals.remove(i.at());
+	if (parent.type() != index::NODE) {
+		m_root = index::make(index::NIL, 0);
+		return;
+	}
+	replace(grandparent, gd, m_nodes[parent.at()].child[1 - pd]);
+	free_node(parent);
 }
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-void cc0::dict<key_t, value_t>::array<type_t>::resize(uint64_t size)
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::critbit<key_t, value_t, policy_t>::clear( void )
 {
-	if (size > m_pool) {
-		type_t *vals = new type_t[size];
-		const uint64_t min = m_size < size ? m_size : size;
-		for (uint64_t i = 0; i < min; ++i) {
-			vals[i] = m_vals[i];
-		}
-		delete [] m_vals;
-		m_vals = vals;
-		m_pool = size;
+	m_vals.clear();
+	m_nodes.truncate(0);
+	m_free = index::make(index::NIL, 0);
+	m_root = index::make(index::NIL, 0);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::critbit<key_t, value_t, policy_t>::reserve(uint64_t entries, uint64_t tables)
+{
+	m_vals.reserve(entries);
+	const uint64_t n = estimate_tables(entries) > tables ? estimate_tables(entries) : tables;
+	if (n > m_nodes.pool_size()) {
+		m_nodes.resize_pool(n);
 	}
-	m_size = size;
 }
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-void cc0::dict<key_t, value_t>::array<type_t>::resize_pool(uint64_t size)
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::critbit<key_t, value_t, policy_t>::compact( void )
 {
-	const uint64_t min = m_size < size ? m_size : size;
-	if (size > m_pool) {
-		type_t *vals = new type_t[size];
-		for (uint64_t i = 0; i < min; ++i) {
-			vals[i] = m_vals[i];
-		}
-		delete [] m_vals;
-		m_vals = vals;
-		m_pool = size;
+	critbit c;
+	c.reserve(m_vals.size());
+	// NOTE: Nodes are allocated in the order they are discovered, which is breadth-first, and their children filled in once they are taken off the queue.
+	array<index> queue(1);
+	queue.reserve(estimate_tables(m_vals.size()) * 2);
+	c.m_root = c.adopt(*this, m_root, queue);
+	for (uint64_t q = 0; q < queue.size(); q += 2) {
+		const node &x = m_nodes[queue[q].at()];
+		const index n = queue[q + 1];
+		c.m_nodes[n.at()].child[0] = c.adopt(*this, x.child[0], queue);
+		c.m_nodes[n.at()].child[1] = c.adopt(*this, x.child[1], queue);
 	}
-	m_size = min;
+	*this = static_cast<critbit&&>(c);
 }
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-type_t &cc0::dict<key_t, value_t>::array<type_t>::add( void )
+template < typename key_t, typename value_t, typename policy_t >
+bool cc0::internal::critbit<key_t, value_t, policy_t>::defrag_step(uint64_t budget)
 {
-	if (m_size >= m_pool) {
-		resize_pool(m_size + m_growth);
+	// NOTE: Every step is charged one unit of the budget. Releasing storage is charged one more unit per element it moves.
+	while (budget > 0) {
+		--budget;
+		if (!pack_values(budget) && !pack_nodes(budget)) {
+			return false;
+		}
 	}
-	return m_vals[m_size++];
+	return true;
 }
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-uint64_t cc0::dict<key_t, value_t>::array<type_t>::size( void ) const
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::critbit<key_t, value_t, policy_t>::allocated_bytes( void ) const
 {
-	return m_size;
+	return m_vals.allocated_bytes() + m_nodes.pool_size() * sizeof(node);
 }
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-uint64_t cc0::dict<key_t, value_t>::array<type_t>::pool_size( void ) const
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::critbit<key_t, value_t, policy_t>::used_bytes( void ) const
 {
-	return m_pool;
+	return m_vals.used_bytes() + (size() > 0 ? size() - 1 : 0) * sizeof(node);
 }
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-type_t &cc0::dict<key_t, value_t>::array<type_t>::operator[](uint64_t i)
+template < typename key_t, typename value_t, typename policy_t >
+template < typename func_t >
+void cc0::internal::critbit<key_t, value_t, policy_t>::for_each(func_t &&f)
 {
-	return m_vals[i];
+	m_vals.for_each(f);
 }
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-const type_t &cc0::dict<key_t, value_t>::array<type_t>::operator[](uint64_t i) const
+template < typename key_t, typename value_t, typename policy_t >
+template < typename func_t >
+void cc0::internal::critbit<key_t, value_t, policy_t>::for_each(func_t &&f) const
 {
-	return m_vals[i];
+	m_vals.for_each(f);
 }
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-type_t &cc0::dict<key_t, value_t>::array<type_t>::first( void )
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::critbit<key_t, value_t, policy_t>::size( void ) const
 {
-	return m_vals[0];
+	return m_vals.size();
 }
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-const type_t &cc0::dict<key_t, value_t>::array<type_t>::first( void ) const
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::critbit<key_t, value_t, policy_t>::prof_lookup(const key_t &key, uint64_t *tables) const
 {
-	return m_vals[0];
+	const path k(key);
+	index i = m_root;
+	uint64_t byte = 0;
+	uint64_t nodes = 0;
+	while (i.type() == index::NODE) {
+		const node &n = m_nodes[i.at()];
+		byte = (n.bit >> 3) + 1;
+		i = n.child[direction(n, k)];
+		++nodes;
+	}
+	if (tables != nullptr) {
+		*tables = nodes;
+	}
+	return byte;
 }
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-type_t &cc0::dict<key_t, value_t>::array<type_t>::last( void )
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::critbit<key_t, value_t, policy_t>::table_count( void ) const
 {
-	return m_vals[m_size - 1];
+	return m_nodes.size();
 }
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-const type_t &cc0::dict<key_t, value_t>::array<type_t>::last( void ) const
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::critbit<key_t, value_t, policy_t>::estimate_tables(uint64_t entries)
 {
-	return m_vals[m_size - 1];
+	return entries > 0 ? entries - 1 : 0;
 }
 
 //
-// dict
+// flat
 //
 
-template < typename key_t, typename value_t >
-typename cc0::dict<key_t, value_t>::table &cc0::dict<key_t, value_t>::init_table(cc0::dict<key_t, value_t>::table &t)
+template < typename key_t, typename value_t, typename policy_t >
+uint32_t cc0::internal::flat<key_t, value_t, policy_t>::match(const group &g, uint8_t c)
 {
-	for (uint64_t i = 0; i < NUM_ENTRIES_IN_TABLE; ++i) {
-		t.idx[i] = { index::NIL, 0 };
+#if CC0_DICT_SSE2
+	const __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(g.ctrl));
+	return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(char(c)))));
+#else
+	uint32_t m = 0;
+	for (uint64_t i = 0; i < NUM_SLOTS_IN_GROUP; ++i) {
+		m |= uint32_t(g.ctrl[i] == c) << i;
 	}
-	t.refs = 0;
-	return t;
+	return m;
+#endif
 }
 
-template < typename key_t, typename value_t >
-template < typename type_t >
-const uint8_t *cc0::dict<key_t, value_t>::bytes(const type_t &t)
+template < typename key_t, typename value_t, typename policy_t >
+uint32_t cc0::internal::flat<key_t, value_t, policy_t>::match_free(const group &g)
 {
-	return reinterpret_cast<const uint8_t*>(&t);
+	// NOTE: Both empty and deleted slots have the upper bit of the control byte set.
+#if CC0_DICT_SSE2
+	return uint32_t(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(g.ctrl))));
+#else
+	uint32_t m = 0;
+	for (uint64_t i = 0; i < NUM_SLOTS_IN_GROUP; ++i) {
+		m |= uint32_t(g.ctrl[i] >> 7) << i;
+	}
+	return m;
+#endif
 }
 
-template < typename key_t, typename value_t >
-bool cc0::dict<key_t, value_t>::cmp(const key_t &a, const key_t &b) const
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::flat<key_t, value_t, policy_t>::lowest(uint32_t mask)
 {
-	const uint8_t *A = bytes(a);
-	const uint8_t *B = bytes(b);
-	for (uint64_t i = 0; i < sizeof(key_t); ++i) {
-		if (A[i] != B[i]) { return false; }
+#if defined(__GNUC__) || defined(__clang__)
+	return uint64_t(__builtin_ctz(mask));
+#else
+	uint64_t i = 0;
+	while ((mask & 1) == 0) {
+		mask >>= 1;
+		++i;
 	}
-	return true;
+	return i;
+#endif
 }
 
-template < typename key_t, typename value_t >
-const value_t *cc0::dict<key_t, value_t>::lookup(const cc0::dict<key_t, value_t>::table &t, const key_t &k, uint64_t level) const
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::flat<key_t, value_t, policy_t>::mask( void ) const
 {
-	const index i = t.idx[bytes(k)[level]];
-	switch (i.type) {
-		case index::TAB: return lookup(m_tabs[i.index], k, level + 1);
-		case index::VAL: return cmp(k, m_vals[i.index].k) ? &m_vals[i.index].v : nullptr;
-	}
-	return nullptr;
+	return m_groups.size() - 1;
 }
 
-template < typename key_t, typename value_t >
-value_t *cc0::dict<key_t, value_t>::lookup(const cc0::dict<key_t, value_t>::table &t, const key_t &k, uint64_t level)
+template < typename key_t, typename value_t, typename policy_t >
+bool cc0::internal::flat<key_t, value_t, policy_t>::find(const key_t &k, uint64_t h, uint64_t &g, uint64_t &s) const
 {
-	const index i = t.idx[bytes(k)[level]];
-	switch (i.type) {
-		case index::TAB: return lookup(m_tabs[i.index], k, level + 1);
-		case index::VAL: return cmp(k, m_vals[i.index].k) ? &m_vals[i.index].v : nullptr;
+	// NOTE: Groups are probed triangularly, which visits every group once since the number of groups is a power of two.
+	const uint8_t c = uint8_t(h & 0x7f);
+	g = (h >> 7) & mask();
+	for (uint64_t step = 1; step <= m_groups.size(); ++step) {
+		const group &x = m_groups[g];
+		for (uint32_t m = match(x, c); m != 0; m &= m - 1) {
+			s = lowest(m);
+			if (m_vals.cmp(x.idx[s], k)) {
+				return true;
+			}
+		}
+		if (match(x, EMPTY) != 0) {
+			return false;
+		}
+		g = (g + step) & mask();
 	}
-	return nullptr;
+	return false;
 }
 
-template < typename key_t, typename value_t >
-value_t &cc0::dict<key_t, value_t>::lookup_or_alloc(uint64_t t, const key_t &k, uint64_t level)
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::flat<key_t, value_t, policy_t>::place(array<group> &groups, uint64_t h, uint64_t e)
 {
-	const index i = m_tabs[t].idx[bytes(k)[level]];
-	switch (i.type) {
-	case index::TAB: return lookup_or_alloc(i.index, k, level + 1);
-	case index::VAL: return cmp(k, m_vals[i.index].k) ? m_vals[i.index].v : alloc(t, k, level);
+	const uint64_t m = groups.size() - 1;
+	uint64_t g = (h >> 7) & m;
+	for (uint64_t step = 1;; ++step) {
+		group &x = groups[g];
+		const uint32_t f = match_free(x);
+		if (f != 0) {
+			const uint64_t s = lowest(f);
+			if (x.ctrl[s] == EMPTY) {
+				++m_used;
+			}
+			x.ctrl[s] = uint8_t(h & 0x7f);
+			x.idx[s] = word_t(e);
+			// NOTE: Fails if the dictionary holds more values than the index policy has room for. See index32 and index64. Aborts rather than throws, since the caller has already started to modify the dictionary.
+			if (uint64_t(x.idx[s]) != e) {
+				cc0::internal::fatal("cc0::dict: too many values for the index policy");
+			}
+			return;
+		}
+		g = (g + step) & m;
 	}
-	return alloc(t, k, level);
-}
-
-template < typename key_t, typename value_t >
-value_t &cc0::dict<key_t, value_t>::alloc(uint64_t t, const key_t &k, uint64_t level)
-{
-	// NOTE: We can be quite wasteful with resources here in the worst case. If the keys only differ in the last byte, we allocate a ton of tables that are never in proper use.
-	index i = m_tabs[t].idx[bytes(k)[level]];
-	if (i.type == index::VAL) { // Collision!
-		init_table(m_tabs.add()).idx[bytes(m_vals[i.index].k)[level + 1]] = i;
-		i.type = index::TAB;
-		i.index = m_tabs.size() - 1;
-		m_tabs[t].idx[bytes(k)[level]] = i;
-		m_tabs.last().refs = 1;
-		return alloc(i.index, k, level + 1);
-	}
-	if (i.type == index::NIL) { // NOTE: If the index is FREE we can re-use the index since we know it is unused in the value array. (We already know type is not TAB since alloc() is only called for values or empty entries).
-		i.index = m_vals.size();
-		m_vals.add();
-		m_vals.last().k = k;
-	}
-	i.type = index::VAL;
-	m_vals[i.index].refs = 1;
-	++m_tabs[t].refs;
-	++m_size;
-	m_tabs[t].idx[bytes(k)[level]] = i;
-	return m_vals[i.index].v;
 }
 
-template < typename key_t, typename value_t >
-void cc0::dict<key_t, value_t>::remove(cc0::dict<key_t, value_t>::table &t, const key_t &k, uint64_t level)
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::flat<key_t, value_t, policy_t>::rehash(uint64_t num_groups)
 {
-	index &i = t.idx[bytes(k)[level]];
-	switch (i.type) {
-	case index::VAL:
-		if (cmp(k, m_vals[i.index].k)) {
-			m_vals[i.index].refs = 0;
-			i.type = index::FREE; // NOTE: If we do not delete the index, we can reuse it if another entry hits this index. FREE denotes just that.
-			--t.refs; // TODO: We could collapse the table if refs is 1. That will require some additional work however as we either need to deallocate the table or be able to reuse it later without needing to scan the entire table array for an empty table.
-			--m_size;
+	array<group> groups(1);
+	groups.create(num_groups);
+	for (uint64_t g = 0; g < num_groups; ++g) {
+		for (uint64_t s = 0; s < NUM_SLOTS_IN_GROUP; ++s) {
+			groups[g].ctrl[s] = EMPTY;
+		}
+	}
+	m_used = 0;
+	for (uint64_t g = 0; g < m_groups.size(); ++g) {
+		const group &x = m_groups[g];
+		for (uint64_t s = 0; s < NUM_SLOTS_IN_GROUP; ++s) {
+			if ((x.ctrl[s] & 0x80) == 0) {
+				place(groups, hash(m_vals.key(x.idx[s])), x.idx[s]);
+			}
 		}
-		break;
-	case index::TAB:
-		remove(m_tabs[i.index], k, level + 1);
 	}
+	m_groups = static_cast<array<group>&&>(groups);
 }
 
-template < typename key_t, typename value_t >
-uint64_t cc0::dict<key_t, value_t>::prof_lookup(const table &t, const key_t &k, uint64_t level) const
+template < typename key_t, typename value_t, typename policy_t >
+const value_t *cc0::internal::flat<key_t, value_t, policy_t>::lookup(const key_t &k) const
 {
-	const index i = t.idx[bytes(k)[level]];
-	switch (i.type) {
-	case index::TAB: return prof_lookup(m_tabs[i.index], k, level + 1);
+	uint64_t g, s;
+	if (m_groups.size() > 0 && find(k, hash(k), g, s)) {
+		return &m_vals.value(m_groups[g].idx[s]);
 	}
-	return level + 1;
+	return nullptr;
 }
 
-template < typename key_t, typename value_t >
-cc0::dict<key_t, value_t>::dict( void ) : m_vals(NUM_ENTRIES_IN_TABLE), m_tabs(16), m_size(0)
+template < typename key_t, typename value_t, typename policy_t >
+value_t &cc0::internal::flat<key_t, value_t, policy_t>::lookup_or_alloc(const key_t &k)
 {
-	init_table(m_tabs.add());
+	const uint64_t h = hash(k);
+	uint64_t g, s;
+	if (m_groups.size() > 0 && find(k, h, g, s)) {
+		return m_vals.value(m_groups[g].idx[s]);
+	}
+	// NOTE: Keep the table at most 7/8 full, counting deleted slots. If most of those are deleted slots, rehash without growing to clear them out.
+	const uint64_t capacity = m_groups.size() * NUM_SLOTS_IN_GROUP;
+	if ((m_used + 1) * 8 > capacity * 7) {
+		rehash(capacity == 0 ? 1 : ((size() + 1) * 16 > capacity * 7 ? m_groups.size() * 2 : m_groups.size()));
+	}
+	const uint64_t e = m_vals.add(k);
+	place(m_groups, h, e);
+	return m_vals.value(e);
 }
 
-template < typename key_t, typename value_t >
-cc0::dict<key_t, value_t>::dict(const dict<key_t, value_t> &d) : m_vals(d.m_vals), m_tabs(d.m_tabs), m_size(d.m_size)
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::flat<key_t, value_t, policy_t>::flat( void ) : m_groups(1), m_used(0)
 {}
 
-template < typename key_t, typename value_t >
-cc0::dict<key_t, value_t> &cc0::dict<key_t, value_t>::operator=(const dict<key_t, value_t> &d)
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::flat<key_t, value_t, policy_t>::flat(const flat<key_t, value_t, policy_t> &d) : m_vals(d.m_vals), m_groups(d.m_groups), m_used(d.m_used)
+{}
+
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::flat<key_t, value_t, policy_t> &cc0::internal::flat<key_t, value_t, policy_t>::operator=(const flat<key_t, value_t, policy_t> &d)
 {
 	if (&d != this) {
 		m_vals = d.m_vals;
-		m_tabs = d.m_tabs;
-		m_size = d.m_size;
+		m_groups = d.m_groups;
+		m_used = d.m_used;
 	}
 	return *this;
 }
 
-template < typename key_t, typename value_t >
-const value_t *cc0::dict<key_t, value_t>::operator[](const key_t &key) const
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::flat<key_t, value_t, policy_t>::flat(flat<key_t, value_t, policy_t> &&d) noexcept : m_vals(static_cast<typename policy_t::layout::template type<key_t, value_t, policy_t>&&>(d.m_vals)), m_groups(static_cast<array<group>&&>(d.m_groups)), m_used(d.m_used)
 {
-	return lookup(m_tabs.first(), key, 0);
+	d.m_used = 0;
 }
 
-template < typename key_t, typename value_t >
-value_t *cc0::dict<key_t, value_t>::operator[](const key_t &key)
+template < typename key_t, typename value_t, typename policy_t >
+cc0::internal::flat<key_t, value_t, policy_t> &cc0::internal::flat<key_t, value_t, policy_t>::operator=(flat<key_t, value_t, policy_t> &&d) noexcept
+{
+	if (&d != this) {
+		m_vals = static_cast<typename policy_t::layout::template type<key_t, value_t, policy_t>&&>(d.m_vals);
+		m_groups = static_cast<array<group>&&>(d.m_groups);
+		m_used = d.m_used;
+		d.m_used = 0;
+	}
+	return *this;
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+const value_t *cc0::internal::flat<key_t, value_t, policy_t>::operator[](const key_t &key) const
 {
-	return lookup(m_tabs.first(), key, 0);
+	return lookup(key);
 }
 
-template < typename key_t, typename value_t >
-const value_t &cc0::dict<key_t, value_t>::operator()(const key_t &key) const
+template < typename key_t, typename value_t, typename policy_t >
+value_t *cc0::internal::flat<key_t, value_t, policy_t>::operator[](const key_t &key)
+{
+	return const_cast<value_t*>(lookup(key));
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::flat<key_t, value_t, policy_t>::lookup_batch(const key_t *keys, uint64_t n, const value_t **out) const
+{
+	// NOTE: Look-ups are done in batches of NUM_BATCH_LOOKUPS. The first group of each key is prefetched for the whole batch, then the value of the first matching slot, before the keys are compared.
+	if (m_groups.size() == 0) {
+		for (uint64_t i = 0; i < n; ++i) {
+			out[i] = nullptr;
+		}
+		return;
+	}
+	uint64_t h[NUM_BATCH_LOOKUPS];
+	for (uint64_t i = 0; i < n; i += NUM_BATCH_LOOKUPS) {
+		const uint64_t count = n - i < NUM_BATCH_LOOKUPS ? n - i : NUM_BATCH_LOOKUPS;
+		for (uint64_t j = 0; j < count; ++j) {
+			h[j] = hash(keys[i + j]);
+			CC0_DICT_PREFETCH(&m_groups[(h[j] >> 7) & mask()]);
+		}
+		for (uint64_t j = 0; j < count; ++j) {
+			const group &x = m_groups[(h[j] >> 7) & mask()];
+			const uint32_t m = match(x, uint8_t(h[j] & 0x7f));
+			if (m != 0) {
+				m_vals.prefetch(x.idx[lowest(m)]);
+			}
+		}
+		for (uint64_t j = 0; j < count; ++j) {
+			uint64_t g, s;
+			out[i + j] = find(keys[i + j], h[j], g, s) ? &m_vals.value(m_groups[g].idx[s]) : nullptr;
+		}
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::flat<key_t, value_t, policy_t>::lookup_batch(const key_t *keys, uint64_t n, value_t **out)
+{
+	static_cast<const flat*>(this)->lookup_batch(keys, n, const_cast<const value_t**>(out));
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+const value_t &cc0::internal::flat<key_t, value_t, policy_t>::operator()(const key_t &key) const
 {
 	return *lookup(key);
 }
 
-template < typename key_t, typename value_t >
-value_t &cc0::dict<key_t, value_t>::operator()(const key_t &key)
+template < typename key_t, typename value_t, typename policy_t >
+value_t &cc0::internal::flat<key_t, value_t, policy_t>::operator()(const key_t &key)
 {
 	return insert(key);
 }
 
-template < typename key_t, typename value_t >
-value_t &cc0::dict<key_t, value_t>::insert(const key_t &key)
+template < typename key_t, typename value_t, typename policy_t >
+value_t &cc0::internal::flat<key_t, value_t, policy_t>::insert(const key_t &key)
 {
-	return lookup_or_alloc(0, key, 0);
+	return lookup_or_alloc(key);
 }
 
-template < typename key_t, typename value_t >
-void cc0::dict<key_t, value_t>::remove(const key_t &key)
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::flat<key_t, value_t, policy_t>::remove(const key_t &key)
 {
-	remove(m_tabs.first(), key, 0);
+	uint64_t g, s;
+	if (m_groups.size() == 0 || !find(key, hash(key), g, s)) {
+		return;
+	}
+	group &x = m_groups[g];
+	m_vals.remove(x.idx[s]);
+	// NOTE: A probe for any key that passes this group would have stopped here if the group has an empty slot, so the slot can be made empty again. Otherwise probes must continue past it.
+	if (match(x, EMPTY) != 0) {
+		x.ctrl[s] = EMPTY;
+		--m_used;
+	} else {
+		x.ctrl[s] = DELETED;
+	}
 }
 
-template < typename key_t, typename value_t >
-uint64_t cc0::dict<key_t, value_t>::allocated_bytes( void ) const
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::flat<key_t, value_t, policy_t>::clear( void )
 {
-	return m_vals.pool_size() * sizeof(entry) + m_tabs.pool_size() * sizeof(table);
+	m_vals.clear();
+	for (uint64_t g = 0; g < m_groups.size(); ++g) {
+		for (uint64_t s = 0; s < NUM_SLOTS_IN_GROUP; ++s) {
+			m_groups[g].ctrl[s] = EMPTY;
+		}
+	}
+	m_used = 0;
 }
 
-template < typename key_t, typename value_t >
-uint64_t cc0::dict<key_t, value_t>::used_bytes( void ) const
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::flat<key_t, value_t, policy_t>::reserve(uint64_t entries, uint64_t tables)
 {
-	uint64_t v = size();
-	uint64_t t = 0;
-	for (uint64_t i = 0; i < m_tabs.size(); ++i) {
-		if (m_tabs[i].refs) {
-			++t;
+	m_vals.reserve(entries);
+	uint64_t n = estimate_tables(entries);
+	while (n < tables) {
+		n *= 2;
+	}
+	if (n > m_groups.size()) {
+		rehash(n);
+	}
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+void cc0::internal::flat<key_t, value_t, policy_t>::compact( void )
+{
+	flat c;
+	c.reserve(size());
+	for (uint64_t g = 0; g < m_groups.size(); ++g) {
+		const group &x = m_groups[g];
+		for (uint64_t s = 0; s < NUM_SLOTS_IN_GROUP; ++s) {
+			if ((x.ctrl[s] & 0x80) == 0) {
+				const key_t &k = m_vals.key(x.idx[s]);
+				const uint64_t e = c.m_vals.add(k);
+				c.m_vals.value(e) = static_cast<value_t&&>(m_vals.value(x.idx[s]));
+				c.place(c.m_groups, hash(k), e);
+			}
 		}
 	}
-	return v * sizeof(entry) + t * sizeof(table);
+	*this = static_cast<flat&&>(c);
 }
 
-template < typename key_t, typename value_t >
-uint64_t cc0::dict<key_t, value_t>::size( void ) const
+template < typename key_t, typename value_t, typename policy_t >
+bool cc0::internal::flat<key_t, value_t, policy_t>::defrag_step(uint64_t budget)
 {
-	return m_size;
+	// NOTE: Every step is charged one unit of the budget. Releasing storage is charged one more unit per element it moves.
+	while (budget > 0) {
+		--budget;
+		uint64_t from, to;
+		if (!m_vals.pack(from, to, budget)) {
+			return false;
+		}
+		if (from != to) {
+			const key_t &k = m_vals.key(from);
+			uint64_t g, s;
+			find(k, hash(k), g, s);
+			m_groups[g].idx[s] = word_t(to);
+			m_vals.relocate(from, to);
+		}
+	}
+	return true;
 }
 
-template < typename key_t, typename value_t >
-uint64_t cc0::dict<key_t, value_t>::prof_lookup(const key_t &key) const
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::flat<key_t, value_t, policy_t>::allocated_bytes( void ) const
 {
-	return prof_lookup(m_tabs[0], key, 0);
+	return m_vals.allocated_bytes() + m_groups.pool_size() * sizeof(group);
 }
 
-template < typename key_t, typename value_t >
-uint64_t cc0::dict<key_t, value_t>::table_count( void ) const
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::flat<key_t, value_t, policy_t>::used_bytes( void ) const
+{
+	return m_vals.used_bytes() + m_groups.size() * sizeof(group);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+template < typename func_t >
+void cc0::internal::flat<key_t, value_t, policy_t>::for_each(func_t &&f)
+{
+	m_vals.for_each(f);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+template < typename func_t >
+void cc0::internal::flat<key_t, value_t, policy_t>::for_each(func_t &&f) const
+{
+	m_vals.for_each(f);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::flat<key_t, value_t, policy_t>::size( void ) const
+{
+	return m_vals.size();
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::flat<key_t, value_t, policy_t>::prof_lookup(const key_t &key, uint64_t *tables) const
+{
+	if (tables != nullptr) {
+		*tables = probes(key);
+	}
+	return sizeof(key_t);
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::flat<key_t, value_t, policy_t>::probes(const key_t &key) const
+{
+	if (m_groups.size() == 0) {
+		return 0;
+	}
+	const uint64_t h = hash(key);
+	const uint8_t c = uint8_t(h & 0x7f);
+	uint64_t g = (h >> 7) & mask();
+	for (uint64_t step = 1; step <= m_groups.size(); ++step) {
+		const group &x = m_groups[g];
+		for (uint32_t m = match(x, c); m != 0; m &= m - 1) {
+			if (m_vals.cmp(x.idx[lowest(m)], key)) {
+				return step;
+			}
+		}
+		if (match(x, EMPTY) != 0) {
+			return step;
+		}
+		g = (g + step) & mask();
+	}
+	return m_groups.size();
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::flat<key_t, value_t, policy_t>::table_count( void ) const
 {
-	return m_tabs.size();
+	return m_groups.size();
+}
+
+template < typename key_t, typename value_t, typename policy_t >
+uint64_t cc0::internal::flat<key_t, value_t, policy_t>::estimate_tables(uint64_t entries)
+{
+	// NOTE: Mirrors the growth of the table, which doubles whenever it would become more than 7/8 full.
+	uint64_t n = 0;
+	while (entries * 8 > n * NUM_SLOTS_IN_GROUP * 7) {
+		n = n > 0 ? n * 2 : 1;
+	}
+	return n;
 }
 
 #endif
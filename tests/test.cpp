@@ -0,0 +1,634 @@
+/// @file
+/// @author github.com/SirJonthe
+/// @date 2023
+/// @copyright Public domain.
+/// @license CC0 1.0
+/// @brief Tests of the dictionary. Build with a C++11 compiler together with dict.cpp, e.g. c++ -std=c++11 tests/test.cpp dict.cpp -o dict_test
+
+#include <cstdio>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "../dict.h"
+
+static int num_failed = 0;
+
+#define TEST(cond) \
+	if (!(cond)) { \
+		std::printf("%s:%d: failed: %s\n", __FILE__, __LINE__, #cond); \
+		++num_failed; \
+	}
+
+struct inline_policy : cc0::dict_policy
+{
+	typedef cc0::inline_layout layout;
+};
+
+struct columnar_policy : cc0::dict_policy
+{
+	typedef cc0::columnar_layout layout;
+};
+
+struct segmented_policy : cc0::dict_policy
+{
+	typedef cc0::segmented_growth growth;
+};
+
+struct segmented_columnar_policy : cc0::dict_policy
+{
+	typedef cc0::segmented_growth growth;
+	typedef cc0::columnar_layout  layout;
+};
+
+struct segmented_critbit_policy : cc0::dict_policy
+{
+	typedef cc0::segmented_growth growth;
+	typedef cc0::critbit_engine   engine;
+};
+
+struct segmented_flat_policy : cc0::dict_policy
+{
+	typedef cc0::segmented_growth growth;
+	typedef cc0::flat_engine      engine;
+};
+
+struct critbit_policy : cc0::dict_policy
+{
+	typedef cc0::critbit_engine engine;
+};
+
+struct flat_policy : cc0::dict_policy
+{
+	typedef cc0::flat_engine engine;
+};
+
+/// @brief Allocates from the heap, and counts the allocations made.
+struct counting_allocator
+{
+	static uint64_t count;
+
+	static void *allocate(uint64_t bytes, uint64_t align) { ++count; return cc0::heap_allocator::allocate(bytes, align); }
+	static void deallocate(void *p, uint64_t bytes, uint64_t align) { cc0::heap_allocator::deallocate(p, bytes, align); }
+};
+
+uint64_t counting_allocator::count = 0;
+
+template < typename policy_t >
+struct counting_policy : policy_t
+{
+	typedef counting_allocator allocator;
+};
+
+// NOTE: Containers such as std::vector only move their elements when growing if moving can not throw. Otherwise they copy them.
+static_assert(std::is_nothrow_move_constructible< cc0::dict<int, int> >::value, "dict must be nothrow move constructible");
+static_assert(std::is_nothrow_move_assignable< cc0::dict<int, int> >::value, "dict must be nothrow move assignable");
+static_assert(std::is_nothrow_move_constructible< cc0::dict<int, int, inline_policy> >::value, "dict must be nothrow move constructible");
+static_assert(std::is_nothrow_move_constructible< cc0::dict<int, int, columnar_policy> >::value, "dict must be nothrow move constructible");
+static_assert(std::is_nothrow_move_constructible< cc0::dict<int, int, segmented_policy> >::value, "dict must be nothrow move constructible");
+static_assert(std::is_nothrow_move_constructible< cc0::dict<int, int, critbit_policy> >::value, "dict must be nothrow move constructible");
+static_assert(std::is_nothrow_move_assignable< cc0::dict<int, int, critbit_policy> >::value, "dict must be nothrow move assignable");
+static_assert(std::is_nothrow_move_constructible< cc0::dict<int, int, flat_policy> >::value, "dict must be nothrow move constructible");
+static_assert(std::is_nothrow_move_assignable< cc0::dict<int, int, flat_policy> >::value, "dict must be nothrow move assignable");
+
+/// @brief A value with a default member initializer, which must be constructed when a value is inserted.
+struct counter
+{
+	uint32_t magic = 0xC0FFEE;
+	uint32_t count = 0;
+};
+
+/// @brief A value that counts its live instances, and is too complex to be copied bytewise.
+struct tracked
+{
+	static int64_t live;
+	static int64_t copies;
+	uint64_t       v;
+
+	tracked( void ) : v(0) { ++live; }
+	tracked(const tracked &t) : v(t.v) { ++live; ++copies; }
+	~tracked( void ) { --live; }
+	tracked &operator=(const tracked &t) { v = t.v; return *this; }
+};
+
+int64_t tracked::live = 0;
+int64_t tracked::copies = 0;
+
+/// @brief A composite key of a tenant and an object, padded to a number of bytes. Keys of the same tenant share all but their last bytes.
+template < uint64_t num_bytes >
+struct tenant_key
+{
+	uint64_t tenant;
+	uint64_t pad[num_bytes / 8 - 2];
+	uint64_t object;
+
+	tenant_key(uint64_t t, uint64_t o) : tenant(t), pad(), object(o) {}
+};
+
+/// @brief Scrambles a number, so that the bytes of keys are uniformly distributed like those of hashes.
+static uint64_t scramble(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+static void test_inline_values_are_constructed( void )
+{
+	cc0::dict<uint32_t, counter, inline_policy> d;
+	for (uint32_t i = 0; i < 1000; ++i) {
+		counter &c = d(i * 2654435761u);
+		TEST(c.magic == 0xC0FFEE && c.count == 0);
+		c.magic = 0xDEAD;
+		c.count = i;
+	}
+	for (uint32_t i = 0; i < 1000; i += 2) {
+		d.remove(i * 2654435761u);
+	}
+	for (uint32_t i = 0; i < 1000; i += 2) {
+		const counter &c = d(i * 2654435761u);
+		TEST(c.magic == 0xC0FFEE && c.count == 0);
+	}
+	d.clear();
+	TEST(d(1).magic == 0xC0FFEE);
+}
+
+static void test_non_trivial_values_are_not_inlined( void )
+{
+	{
+		cc0::dict<uint32_t, tracked, inline_policy> d;
+		for (uint32_t i = 0; i < 1000; ++i) {
+			d(i * 2654435761u).v = i;
+		}
+		for (uint32_t i = 0; i < 1000; i += 2) {
+			d.remove(i * 2654435761u);
+		}
+		TEST(tracked::live == 500);
+		for (uint32_t i = 1; i < 1000; i += 2) {
+			TEST(d[i * 2654435761u] != nullptr && d[i * 2654435761u]->v == i);
+		}
+		cc0::dict<uint32_t, tracked, inline_policy> c(d);
+		TEST(tracked::live == 1000);
+		d.clear();
+		TEST(tracked::live == 500);
+	}
+	TEST(tracked::live == 0);
+}
+
+static void test_containers_move_dicts( void )
+{
+	{
+		std::vector< cc0::dict<uint32_t, tracked> > v;
+		for (uint32_t i = 0; i < 100; ++i) {
+			v.emplace_back();
+			for (uint32_t j = 0; j < 100; ++j) {
+				v.back()(j).v = j;
+			}
+		}
+		tracked::copies = 0;
+		v.reserve(v.capacity() * 2);
+		TEST(tracked::copies == 0);
+		TEST(v[99][42] != nullptr && v[99][42]->v == 42);
+	}
+	TEST(tracked::live == 0);
+}
+
+template < typename policy_t >
+static void test_defrag_step_is_bounded( void )
+{
+	{
+		cc0::dict<uint32_t, tracked, policy_t> d;
+		for (uint32_t i = 0; i < 100000; ++i) {
+			d(i * 2654435761u).v = i;
+		}
+		for (uint32_t i = 0; i < 100000; ++i) {
+			if (i % 10 != 0) {
+				d.remove(i * 2654435761u);
+			}
+		}
+		const uint64_t allocated = d.allocated_bytes();
+		bool more = true;
+		while (more) {
+			tracked::copies = 0;
+			more = d.defrag_step(64);
+			TEST(tracked::copies <= 64);
+		}
+		for (uint32_t i = 0; i < 100000; i += 10) {
+			TEST(d[i * 2654435761u] != nullptr && d[i * 2654435761u]->v == i);
+		}
+		d.compact();
+		TEST(d.allocated_bytes() < allocated);
+		TEST(d.size() == 10000);
+	}
+	TEST(tracked::live == 0);
+}
+
+template < typename policy_t >
+static void test_tables_grow_and_shrink( void )
+{
+	// NOTE: The keys only differ in one byte, so they all sit in the same table, which grows through every table size and shrinks back.
+	for (uint32_t shift = 0; shift < 32; shift += 16) {
+		cc0::dict<uint32_t, uint32_t, policy_t> d;
+		bool present[256] = {};
+		for (uint32_t n = 0; n < 256; ++n) {
+			d(n << shift) = n + 1;
+			present[n] = true;
+			for (uint32_t i = 0; i < 256; ++i) {
+				TEST(present[i] ? d[i << shift] != nullptr && *d[i << shift] == i + 1 : d[i << shift] == nullptr);
+			}
+		}
+		for (uint32_t i = 0; i < 256; ++i) {
+			uint64_t tables = 0;
+			d.prof_lookup(i << shift, &tables);
+			TEST(tables == 1);
+		}
+		const uint64_t used = d.used_bytes();
+		for (uint32_t n = 0; n < 256; ++n) {
+			const uint32_t k = (n * 167) % 256;
+			d.remove(k << shift);
+			present[k] = false;
+			for (uint32_t i = 0; i < 256; ++i) {
+				TEST(present[i] ? d[i << shift] != nullptr && *d[i << shift] == i + 1 : d[i << shift] == nullptr);
+			}
+			if (n == 252) {
+				TEST(d.used_bytes() * 8 < used);
+			}
+		}
+		TEST(d.size() == 0);
+	}
+}
+
+template < uint64_t num_bytes >
+static void test_shared_prefixes_are_compressed( void )
+{
+	typedef tenant_key<num_bytes> key_t;
+	cc0::dict<key_t, uint64_t> d;
+	uint64_t tables = 0;
+
+	// NOTE: Two keys differing only in their last byte need a single table.
+	d(key_t(1, 0)) = 1;
+	d(key_t(1, uint64_t(1) << 56)) = 2;
+	TEST(d.prof_lookup(key_t(1, 0), &tables) == num_bytes && tables == 1);
+	TEST(d.prof_lookup(key_t(1, uint64_t(1) << 56), &tables) == num_bytes && tables == 1);
+	TEST(d.table_count() == 1);
+	d.clear();
+
+	for (uint64_t t = 0; t < 4; ++t) {
+		for (uint64_t o = 0; o < 1000; ++o) {
+			d(key_t(t, o)) = t * 1000 + o;
+		}
+	}
+	for (uint64_t t = 0; t < 4; ++t) {
+		for (uint64_t o = 0; o < 1000; ++o) {
+			TEST(d[key_t(t, o)] != nullptr && *d[key_t(t, o)] == t * 1000 + o);
+			d.prof_lookup(key_t(t, o), &tables);
+			TEST(tables <= 3);
+		}
+		TEST(d[key_t(t, 1000)] == nullptr);
+		TEST(d[key_t(t + 4, 0)] == nullptr);
+	}
+	for (uint64_t t = 0; t < 4; ++t) {
+		for (uint64_t o = 0; o < 1000; o += 2) {
+			d.remove(key_t(t, o));
+		}
+	}
+	for (uint64_t t = 0; t < 4; ++t) {
+		for (uint64_t o = 0; o < 1000; ++o) {
+			TEST(o % 2 == 0 ? d[key_t(t, o)] == nullptr : d[key_t(t, o)] != nullptr && *d[key_t(t, o)] == t * 1000 + o);
+		}
+	}
+	TEST(d.size() == 2000);
+}
+
+template < typename policy_t >
+static void test_churn_reuses_memory( void )
+{
+	cc0::dict<uint64_t, uint64_t, policy_t> d;
+	uint64_t tables = 0;
+
+	// NOTE: 0x100 and 0x200 share their first byte, so they get a table below the root, which collapses once one of them is removed.
+	d(0x100) = 1;
+	d(0x101) = 2;
+	d(0x200) = 3;
+	d.prof_lookup(0x100, &tables);
+	TEST(tables == 2);
+	d.remove(0x200);
+	d.prof_lookup(0x100, &tables);
+	TEST(tables == 1);
+	TEST(d[0x100] != nullptr && *d[0x100] == 1 && d[0x101] != nullptr && *d[0x101] == 2 && d[0x200] == nullptr);
+	d.clear();
+
+	// NOTE: Every round replaces all keys, so the dictionary never holds more than n values, and must reuse the memory of removed values and tables.
+	const uint64_t n = 10000;
+	uint64_t allocated = 0;
+	for (uint64_t i = 0; i < n; ++i) {
+		d(i * 0x9E3779B97F4A7C15ULL) = i;
+	}
+	for (uint64_t round = 1; round <= 20; ++round) {
+		for (uint64_t i = round * n; i < (round + 1) * n; ++i) {
+			d.remove((i - n) * 0x9E3779B97F4A7C15ULL);
+			d(i * 0x9E3779B97F4A7C15ULL) = i;
+		}
+		if (round == 1) {
+			allocated = d.allocated_bytes();
+		}
+		TEST(d.allocated_bytes() == allocated);
+		TEST(d.size() == n);
+	}
+	for (uint64_t i = 20 * n; i < 21 * n; ++i) {
+		TEST(d[i * 0x9E3779B97F4A7C15ULL] != nullptr && *d[i * 0x9E3779B97F4A7C15ULL] == i);
+		TEST(d[(i - n) * 0x9E3779B97F4A7C15ULL] == nullptr);
+	}
+}
+
+template < typename policy_t >
+static void test_lookup_batch_matches_lookup( void )
+{
+	cc0::dict<uint32_t, uint32_t, policy_t> d;
+	for (uint32_t i = 0; i < 10000; ++i) {
+		d(i * 2654435761u) = i;
+	}
+	// NOTE: Hits and misses are mixed, and the number of keys is not a multiple of the number of look-ups interleaved at a time.
+	std::vector<uint32_t> keys;
+	for (uint32_t i = 0; i < 1001; ++i) {
+		keys.push_back(i * 7 * 2654435761u);
+		keys.push_back((i * 7 + 20000) * 2654435761u);
+	}
+	std::vector<uint32_t*> out(keys.size());
+	d.lookup_batch(keys.data(), keys.size(), out.data());
+	for (uint64_t i = 0; i < keys.size(); ++i) {
+		TEST(out[i] == d[keys[i]]);
+		TEST(i % 2 == 0 && i / 2 * 7 < 10000 ? out[i] != nullptr && *out[i] == i / 2 * 7 : out[i] == nullptr);
+	}
+	const cc0::dict<uint32_t, uint32_t, policy_t> &c = d;
+	std::vector<const uint32_t*> const_out(keys.size());
+	c.lookup_batch(keys.data(), keys.size(), const_out.data());
+	for (uint64_t i = 0; i < keys.size(); ++i) {
+		TEST(const_out[i] == c[keys[i]]);
+	}
+}
+
+template < typename policy_t >
+static void test_matches_unordered_map( void )
+{
+	cc0::dict<uint64_t, uint64_t, policy_t> d;
+	std::unordered_map<uint64_t, uint64_t> m;
+	uint64_t r = 1;
+	for (uint64_t i = 0; i < 200000; ++i) {
+		r = r * 6364136223846793005ULL + 1442695040888963407ULL;
+		// NOTE: Half of the keys are small numbers that share most of their bits, and half are spread over the whole key space.
+		const uint64_t x = (r >> 33) % 5000;
+		const uint64_t k = (r >> 32) & 1 ? x : x * 0x9E3779B97F4A7C15ULL;
+		switch ((r >> 16) % 3) {
+		case 0:
+			d(k) = i;
+			m[k] = i;
+			break;
+		case 1:
+			d.remove(k);
+			m.erase(k);
+			break;
+		default:
+			TEST(m.count(k) > 0 ? d[k] != nullptr && *d[k] == m[k] : d[k] == nullptr);
+			break;
+		}
+		TEST(d.size() == m.size());
+	}
+	for (std::unordered_map<uint64_t, uint64_t>::const_iterator i = m.begin(); i != m.end(); ++i) {
+		TEST(d[i->first] != nullptr && *d[i->first] == i->second);
+	}
+	const cc0::dict<uint64_t, uint64_t, policy_t> c(d);
+	for (std::unordered_map<uint64_t, uint64_t>::const_iterator i = m.begin(); i != m.end(); ++i) {
+		TEST(c[i->first] != nullptr && *c[i->first] == i->second);
+	}
+	TEST(c.size() == m.size());
+}
+
+static void test_columnar_layout( void )
+{
+	{
+		cc0::dict<uint32_t, tracked, columnar_policy> d;
+		for (uint32_t i = 0; i < 10000; ++i) {
+			d(i * 2654435761u).v = i;
+		}
+		for (uint32_t i = 0; i < 10000; i += 3) {
+			d.remove(i * 2654435761u);
+		}
+		TEST(d.size() == 6666);
+		// NOTE: The value column has no holes, so removed values are replaced by new values, which later insertions reuse.
+		TEST(tracked::live == 10000);
+		const uint64_t allocated = d.allocated_bytes();
+		for (uint32_t i = 0; i < 10000; i += 3) {
+			tracked &t = d(i * 2654435761u);
+			TEST(t.v == 0);
+			t.v = i + 1;
+		}
+		TEST(d.allocated_bytes() == allocated);
+		TEST(tracked::live == 10000);
+		cc0::dict<uint32_t, tracked, columnar_policy> c(d);
+		TEST(tracked::live == 20000);
+		cc0::dict<uint32_t, tracked, columnar_policy> m(static_cast<cc0::dict<uint32_t, tracked, columnar_policy>&&>(c));
+		TEST(tracked::live == 20000);
+		for (uint32_t i = 0; i < 10000; ++i) {
+			TEST(m[i * 2654435761u] != nullptr && m[i * 2654435761u]->v == (i % 3 == 0 ? i + 1 : i));
+		}
+	}
+	TEST(tracked::live == 0);
+
+	// NOTE: An interleaved pair of a 4-byte key and an 8-byte value is padded to 16 bytes, while the columns take 12 bytes per pair.
+	cc0::dict<uint32_t, uint64_t> interleaved;
+	cc0::dict<uint32_t, uint64_t, columnar_policy> columnar;
+	for (uint32_t i = 0; i < 10000; ++i) {
+		interleaved(i * 2654435761u) = i;
+		columnar(i * 2654435761u) = i;
+	}
+	TEST(columnar.used_bytes() + 3 * 10000 < interleaved.used_bytes());
+}
+
+template < typename policy_t >
+static void test_segmented_values_do_not_move( void )
+{
+	cc0::dict<uint32_t, uint32_t, policy_t> d;
+	std::vector<uint32_t*> p;
+	for (uint32_t i = 0; i < 1000; ++i) {
+		p.push_back(&d(i * 2654435761u));
+		*p.back() = i;
+	}
+	// NOTE: Storage grows, and is then reused after removing values.
+	for (uint32_t i = 1000; i < 100000; ++i) {
+		d(i * 2654435761u) = i;
+	}
+	for (uint32_t i = 1000; i < 100000; ++i) {
+		d.remove(i * 2654435761u);
+	}
+	for (uint32_t i = 100000; i < 200000; ++i) {
+		d(i * 2654435761u) = i;
+	}
+	for (uint32_t i = 0; i < 1000; ++i) {
+		TEST(d[i * 2654435761u] == p[i] && *p[i] == i);
+	}
+}
+
+template < typename policy_t >
+static void test_reserve_does_not_reallocate( void )
+{
+	// NOTE: The number of tables reserved is estimated for keys whose bytes are uniformly distributed.
+	const uint64_t n = 100000;
+	cc0::dict<uint64_t, uint64_t, policy_t> d;
+	for (uint64_t i = 0; i < 100; ++i) {
+		d(scramble(i)) = i;
+	}
+	d.reserve(n);
+	const uint64_t allocated = d.allocated_bytes();
+	for (uint64_t i = 100; i < n; ++i) {
+		d(scramble(i)) = i;
+	}
+	TEST(d.allocated_bytes() == allocated);
+	for (uint64_t i = 0; i < n; ++i) {
+		TEST(d[scramble(i)] != nullptr && *d[scramble(i)] == i);
+	}
+}
+
+template < typename policy_t >
+static void test_compact_keeps_contents( void )
+{
+	cc0::dict<uint64_t, uint64_t, policy_t> d;
+	for (uint64_t i = 0; i < 100000; ++i) {
+		d(scramble(i)) = i;
+	}
+	for (uint64_t i = 0; i < 100000; ++i) {
+		if (i % 10 != 0) {
+			d.remove(scramble(i));
+		}
+	}
+	const uint64_t allocated = d.allocated_bytes();
+	d.compact();
+	TEST(d.allocated_bytes() == d.used_bytes());
+	TEST(d.allocated_bytes() * 4 < allocated);
+	TEST(d.size() == 10000);
+	for (uint64_t i = 0; i < 100000; ++i) {
+		TEST(i % 10 == 0 ? d[scramble(i)] != nullptr && *d[scramble(i)] == i : d[scramble(i)] == nullptr);
+	}
+}
+
+template < typename policy_t >
+static void test_clear_keeps_capacity( void )
+{
+	cc0::dict<uint64_t, uint64_t, counting_policy<policy_t> > d;
+	for (uint64_t i = 0; i < 10000; ++i) {
+		d(scramble(i)) = i;
+	}
+	const uint64_t allocated = d.allocated_bytes();
+	d.clear();
+	TEST(d.size() == 0);
+	TEST(d[scramble(0)] == nullptr);
+	TEST(d.allocated_bytes() == allocated);
+	const uint64_t count = counting_allocator::count;
+	TEST(count > 0);
+	for (uint64_t i = 0; i < 10000; ++i) {
+		d(scramble(i)) = i + 1;
+	}
+	TEST(counting_allocator::count == count);
+	TEST(d.allocated_bytes() == allocated);
+	for (uint64_t i = 0; i < 10000; ++i) {
+		TEST(d[scramble(i)] != nullptr && *d[scramble(i)] == i + 1);
+	}
+}
+
+/// @brief Stores the key plus one in each value.
+struct add_one
+{
+	void operator()(const uint64_t &k, uint64_t &v) const { v = k + 1; }
+};
+
+/// @brief Counts the visits to each key, and checks that each value is the one stored at its key.
+struct visitor
+{
+	std::unordered_map<uint64_t, uint64_t> *visits;
+
+	void operator()(const uint64_t &k, const uint64_t &v) const
+	{
+		TEST(v == k + 1);
+		++(*visits)[k];
+	}
+};
+
+template < typename policy_t >
+static void test_for_each_visits_live_pairs( void )
+{
+	cc0::dict<uint64_t, uint64_t, policy_t> d;
+	for (uint64_t i = 0; i < 10000; ++i) {
+		d(i % 2 == 0 ? scramble(i) : i) = 0;
+	}
+	for (uint64_t i = 0; i < 10000; i += 3) {
+		d.remove(i % 2 == 0 ? scramble(i) : i);
+	}
+	d.for_each(add_one());
+	std::unordered_map<uint64_t, uint64_t> visits;
+	visitor f = { &visits };
+	const cc0::dict<uint64_t, uint64_t, policy_t> &c = d;
+	c.for_each(f);
+	TEST(visits.size() == d.size());
+	for (uint64_t i = 0; i < 10000; ++i) {
+		const uint64_t k = i % 2 == 0 ? scramble(i) : i;
+		TEST(i % 3 == 0 ? visits.count(k) == 0 : visits.count(k) == 1 && visits[k] == 1);
+	}
+}
+
+int main()
+{
+	test_inline_values_are_constructed();
+	test_non_trivial_values_are_not_inlined();
+	test_containers_move_dicts();
+	test_defrag_step_is_bounded<cc0::dict_policy>();
+	test_defrag_step_is_bounded<critbit_policy>();
+	test_defrag_step_is_bounded<flat_policy>();
+	test_defrag_step_is_bounded<columnar_policy>();
+	test_tables_grow_and_shrink<cc0::dict_policy>();
+	test_tables_grow_and_shrink<inline_policy>();
+	test_tables_grow_and_shrink<columnar_policy>();
+	test_shared_prefixes_are_compressed<16>();
+	test_shared_prefixes_are_compressed<32>();
+	test_churn_reuses_memory<cc0::dict_policy>();
+	test_churn_reuses_memory<inline_policy>();
+	test_churn_reuses_memory<columnar_policy>();
+	test_lookup_batch_matches_lookup<cc0::dict_policy>();
+	test_lookup_batch_matches_lookup<inline_policy>();
+	test_lookup_batch_matches_lookup<critbit_policy>();
+	test_lookup_batch_matches_lookup<flat_policy>();
+	test_matches_unordered_map<critbit_policy>();
+	test_matches_unordered_map<flat_policy>();
+	test_columnar_layout();
+	test_segmented_values_do_not_move<segmented_policy>();
+	test_segmented_values_do_not_move<segmented_columnar_policy>();
+	test_segmented_values_do_not_move<segmented_critbit_policy>();
+	test_segmented_values_do_not_move<segmented_flat_policy>();
+	test_reserve_does_not_reallocate<cc0::dict_policy>();
+	test_reserve_does_not_reallocate<inline_policy>();
+	test_reserve_does_not_reallocate<columnar_policy>();
+	test_reserve_does_not_reallocate<critbit_policy>();
+	test_reserve_does_not_reallocate<flat_policy>();
+	test_compact_keeps_contents<cc0::dict_policy>();
+	test_compact_keeps_contents<inline_policy>();
+	test_compact_keeps_contents<columnar_policy>();
+	test_compact_keeps_contents<critbit_policy>();
+	test_compact_keeps_contents<flat_policy>();
+	test_clear_keeps_capacity<cc0::dict_policy>();
+	test_clear_keeps_capacity<inline_policy>();
+	test_clear_keeps_capacity<columnar_policy>();
+	test_clear_keeps_capacity<segmented_policy>();
+	test_clear_keeps_capacity<critbit_policy>();
+	test_clear_keeps_capacity<flat_policy>();
+	test_for_each_visits_live_pairs<cc0::dict_policy>();
+	test_for_each_visits_live_pairs<inline_policy>();
+	test_for_each_visits_live_pairs<columnar_policy>();
+	test_for_each_visits_live_pairs<segmented_policy>();
+	test_for_each_visits_live_pairs<critbit_policy>();
+	test_for_each_visits_live_pairs<flat_policy>();
+	if (num_failed > 0) {
+		std::printf("%d tests failed\n", num_failed);
+		return 1;
+	}
+	std::printf("all tests passed\n");
+	return 0;
+}